@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "Matrix.hpp"
+#include "Ray.hpp"
+#include "Tuples/Point.hpp"
+#include "Tuples/Vector.hpp"
+
+namespace Karbon
+{
+    struct AABB
+    {
+        [[nodiscard]] constexpr AABB()
+            : m_min(std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()),
+              m_max(-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity())
+        {
+        }
+
+        [[nodiscard]] constexpr AABB(const Point &min, const Point &max) : m_min(min), m_max(max) {}
+
+        // grow the box so it contains the point
+        constexpr AABB &expand(const Point &p) noexcept
+        {
+            m_min = Point(std::min(m_min.x, p.x), std::min(m_min.y, p.y), std::min(m_min.z, p.z));
+            m_max = Point(std::max(m_max.x, p.x), std::max(m_max.y, p.y), std::max(m_max.z, p.z));
+
+            return *this;
+        }
+
+        // grow the box so it contains the other box
+        constexpr AABB &expand(const AABB &other) noexcept
+        {
+            m_min = Point(std::min(m_min.x, other.m_min.x), std::min(m_min.y, other.m_min.y), std::min(m_min.z, other.m_min.z));
+            m_max = Point(std::max(m_max.x, other.m_max.x), std::max(m_max.y, other.m_max.y), std::max(m_max.z, other.m_max.z));
+
+            return *this;
+        }
+
+        [[nodiscard]] constexpr bool is_valid() const noexcept
+        {
+            return m_min.x <= m_max.x && m_min.y <= m_max.y && m_min.z <= m_max.z;
+        }
+
+        [[nodiscard]] constexpr Point centroid() const noexcept
+        {
+            return Point((m_min.x + m_max.x) * 0.5f, (m_min.y + m_max.y) * 0.5f, (m_min.z + m_max.z) * 0.5f);
+        }
+
+        [[nodiscard]] constexpr Vector extent() const noexcept
+        {
+            return m_max - m_min;
+        }
+
+        [[nodiscard]] constexpr float surface_area() const noexcept
+        {
+            if (!is_valid())
+                return 0;
+
+            Vector e = extent();
+
+            return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+
+        // index of the axis with the largest extent (0 = x, 1 = y, 2 = z)
+        [[nodiscard]] constexpr int longest_axis() const noexcept
+        {
+            Vector e = extent();
+
+            if (e.x >= e.y && e.x >= e.z)
+                return 0;
+
+            return e.y >= e.z ? 1 : 2;
+        }
+
+        /**
+         * @brief Slab test against the box
+         *
+         * @param origin The ray origin
+         * @param inverse_direction Component-wise 1 / direction of the ray
+         * @param t_max Upper bound of the interval, anything farther away is rejected
+         * @return float The entry distance or infinity if the box is missed
+         */
+        [[nodiscard]] constexpr float intersects(const Point &origin, const Vector &inverse_direction, const float t_max) const noexcept
+        {
+            float tx1 = (m_min.x - origin.x) * inverse_direction.x;
+            float tx2 = (m_max.x - origin.x) * inverse_direction.x;
+
+            float t_near = std::min(tx1, tx2);
+            float t_far = std::max(tx1, tx2);
+
+            float ty1 = (m_min.y - origin.y) * inverse_direction.y;
+            float ty2 = (m_max.y - origin.y) * inverse_direction.y;
+
+            t_near = std::max(t_near, std::min(ty1, ty2));
+            t_far = std::min(t_far, std::max(ty1, ty2));
+
+            float tz1 = (m_min.z - origin.z) * inverse_direction.z;
+            float tz2 = (m_max.z - origin.z) * inverse_direction.z;
+
+            t_near = std::max(t_near, std::min(tz1, tz2));
+            t_far = std::min(t_far, std::max(tz1, tz2));
+
+            if (t_far >= t_near && t_far > 0 && t_near < t_max)
+                return t_near;
+
+            return std::numeric_limits<float>::infinity();
+        }
+
+        // world space box of a local space box under an affine transform
+        [[nodiscard]] constexpr AABB transform(const Matrix4 &matrix) const noexcept
+        {
+            AABB result;
+
+            for (char i = 0; i < 8; i++)
+            {
+                Point corner((i & 1) ? m_max.x : m_min.x, (i & 2) ? m_max.y : m_min.y, (i & 4) ? m_max.z : m_min.z);
+
+                result.expand(matrix * corner);
+            }
+
+            return result;
+        }
+
+        friend std::ostream &operator<<(std::ostream &os, const AABB &box)
+        {
+            os << "AABB(min=" << box.m_min << ", max=" << box.m_max << ")";
+            return os;
+        }
+
+        Point m_min;
+        Point m_max;
+    };
+
+    // component-wise reciprocal of a ray direction, used by the slab tests
+    [[nodiscard]] constexpr Vector inverse_direction(const Vector &direction) noexcept
+    {
+        return Vector(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    }
+} // namespace Karbon
@@ -0,0 +1,517 @@
+#pragma once
+
+#include "Acceleration/AABB.hpp"
+#include "Acceleration/BVHBuilder.hpp"
+#include "Acceleration/Hit.hpp"
+#include "Acceleration/RayPacket.hpp"
+#include "Acceleration/TransformBatch.hpp"
+#include "Constants.hpp"
+#include "Ray.hpp"
+#include "Shapes/Shape.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief Bounding volume hierarchy over the bounded shapes of a World
+     *
+     * Built top-down with a binned surface area heuristic (BVHBuilder). Nodes are stored in a flat array with
+     * siblings next to each other, and the shapes are reordered so every leaf references a
+     * contiguous range of them.
+     */
+    struct BVH
+    {
+        static constexpr uint32_t kMaxLeafSize = 4;
+        static constexpr int kStackSize = 64; // the build stops splitting below kStackSize - 1 levels, so traversal can't overflow it
+
+        // relative costs used by the SAH, a shape test is a matrix transform plus the actual intersection
+        static constexpr float kTraversalCost = 1.0f;
+        static constexpr float kIntersectionCost = 4.0f;
+
+        [[nodiscard]] BVH() = default;
+
+        void build(const std::vector<Shape *> &shapes)
+        {
+            PROFILE_FUNCTION();
+
+            m_nodes.clear();
+            m_inverse_transforms.clear();
+            m_shapes = shapes;
+
+            if (m_shapes.empty())
+                return;
+
+            std::vector<AABB> bounds;
+            bounds.reserve(m_shapes.size());
+
+            for (const auto &shape : m_shapes)
+                bounds.emplace_back(shape->get_world_bounds());
+
+            BVHBuilder builder(m_nodes, std::move(bounds), {kTraversalCost, kIntersectionCost, kMaxLeafSize, kStackSize - 1}, [this](const uint32_t i, const uint32_t j)
+                               { std::swap(m_shapes[i], m_shapes[j]); });
+            builder.build();
+
+            // in leaf order, so a leaf moves the ray into all of its shapes with one batched transform
+            m_inverse_transforms.reserve(m_shapes.size());
+
+            for (const auto &shape : m_shapes)
+                m_inverse_transforms.push_back(shape->get_inverse_transform());
+        }
+
+        /**
+         * @brief Collects every positive intersection along the ray (unsorted)
+         *
+         * @param ray The ray in world space
+         * @param xs Intersections are appended to this vector
+         */
+        void intersects(const Ray &ray, std::vector<std::pair<float, Shape *>> &xs) const
+        {
+            PROFILE_FUNCTION();
+
+            if (m_nodes.empty())
+                return;
+
+            const Vector inv_dir = inverse_direction(ray.m_direction);
+            constexpr float t_max = std::numeric_limits<float>::infinity();
+
+            uint32_t stack[kStackSize];
+            int stack_ptr = 0;
+
+            if (m_nodes[0].m_bounds.intersects(ray.m_origin, inv_dir, t_max) == std::numeric_limits<float>::infinity())
+                return;
+
+            stack[stack_ptr++] = 0;
+
+            while (stack_ptr > 0)
+            {
+                const BVHNode &node = m_nodes[stack[--stack_ptr]];
+
+                if (node.is_leaf())
+                {
+                    Ray local_rays[TransformBatch::kWidth];
+                    const uint32_t end = node.m_left_first + node.m_count;
+
+                    for (uint32_t first = node.m_left_first; first < end; first += TransformBatch::kWidth)
+                    {
+                        const uint32_t count = std::min(TransformBatch::kWidth, end - first);
+
+                        m_inverse_transforms.transform(ray, first, count, local_rays);
+
+                        for (uint32_t i = 0; i < count; i++)
+                        {
+                            auto shape_xs = m_shapes[first + i]->intersects_local(local_rays[i]);
+                            if (shape_xs.first > 0)
+                                xs.emplace_back(shape_xs);
+                        }
+                    }
+
+                    continue;
+                }
+
+                for (uint32_t child = node.m_left_first; child < node.m_left_first + 2; child++)
+                {
+                    if (m_nodes[child].m_bounds.intersects(ray.m_origin, inv_dir, t_max) != std::numeric_limits<float>::infinity())
+                    {
+                        assert(stack_ptr < kStackSize);
+                        stack[stack_ptr++] = child;
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Finds the nearest intersection inside (t_min, hit.m_t), nodes are visited front to back
+         *
+         * Never allocates, the traversal stack lives on the call stack.
+         *
+         * @param ray The ray in world space
+         * @param t_min Lower bound of the interval
+         * @param hit In: m_t is the upper bound of the interval. Out: the nearest hit if one was found
+         * @return true if the hit was updated
+         */
+        bool closest_hit(const Ray &ray, const float t_min, Hit &hit) const
+        {
+            PROFILE_FUNCTION();
+
+            if (m_nodes.empty())
+                return false;
+
+            const Vector inv_dir = inverse_direction(ray.m_direction);
+
+            if (m_nodes[0].m_bounds.intersects(ray.m_origin, inv_dir, hit.m_t) == std::numeric_limits<float>::infinity())
+                return false;
+
+            bool found = false;
+
+            // entry distance is kept next to every pushed node so nodes behind a closer hit are skipped on pop
+            uint32_t stack[kStackSize];
+            float stack_t[kStackSize];
+            int stack_ptr = 0;
+
+            stack[stack_ptr] = 0;
+            stack_t[stack_ptr++] = 0;
+
+            while (stack_ptr > 0)
+            {
+                --stack_ptr;
+
+                if (stack_t[stack_ptr] > hit.m_t)
+                    continue;
+
+                const BVHNode &node = m_nodes[stack[stack_ptr]];
+
+                if (node.is_leaf())
+                {
+                    Ray local_rays[TransformBatch::kWidth];
+                    const uint32_t end = node.m_left_first + node.m_count;
+
+                    for (uint32_t first = node.m_left_first; first < end; first += TransformBatch::kWidth)
+                    {
+                        const uint32_t count = std::min(TransformBatch::kWidth, end - first);
+
+                        m_inverse_transforms.transform(ray, first, count, local_rays);
+
+                        for (uint32_t i = 0; i < count; i++)
+                            found |= m_shapes[first + i]->closest_hit_local(local_rays[i], t_min, hit);
+                    }
+
+                    continue;
+                }
+
+                uint32_t near_child = node.m_left_first;
+                uint32_t far_child = node.m_left_first + 1;
+
+                float near_t = m_nodes[near_child].m_bounds.intersects(ray.m_origin, inv_dir, hit.m_t);
+                float far_t = m_nodes[far_child].m_bounds.intersects(ray.m_origin, inv_dir, hit.m_t);
+
+                if (far_t < near_t)
+                {
+                    std::swap(near_child, far_child);
+                    std::swap(near_t, far_t);
+                }
+
+                // push the far child first so the near one is popped next
+                if (far_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr] = far_child;
+                    stack_t[stack_ptr++] = far_t;
+                }
+
+                if (near_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr] = near_child;
+                    stack_t[stack_ptr++] = near_t;
+                }
+            }
+
+            return found;
+        }
+
+        /**
+         * @brief True if the ray hits any shape inside (t_min, t_max), stops at the first one it finds
+         *
+         * Children are visited near first like in closest_hit, a blocker close to the ray origin is then found before
+         * the far subtree is opened. The interval never shrinks, so no entry distances are kept on the stack.
+         *
+         * @param ray The ray in world space
+         * @param t_min Lower bound of the interval
+         * @param t_max Upper bound of the interval
+         */
+        [[nodiscard]] bool occluded(const Ray &ray, const float t_min, const float t_max) const
+        {
+            PROFILE_FUNCTION();
+
+            if (m_nodes.empty())
+                return false;
+
+            const Vector inv_dir = inverse_direction(ray.m_direction);
+
+            if (m_nodes[0].m_bounds.intersects(ray.m_origin, inv_dir, t_max) == std::numeric_limits<float>::infinity())
+                return false;
+
+            uint32_t stack[kStackSize];
+            int stack_ptr = 0;
+
+            stack[stack_ptr++] = 0;
+
+            while (stack_ptr > 0)
+            {
+                const BVHNode &node = m_nodes[stack[--stack_ptr]];
+
+                if (node.is_leaf())
+                {
+                    Ray local_rays[TransformBatch::kWidth];
+                    const uint32_t end = node.m_left_first + node.m_count;
+
+                    for (uint32_t first = node.m_left_first; first < end; first += TransformBatch::kWidth)
+                    {
+                        const uint32_t count = std::min(TransformBatch::kWidth, end - first);
+
+                        m_inverse_transforms.transform(ray, first, count, local_rays);
+
+                        for (uint32_t i = 0; i < count; i++)
+                            if (m_shapes[first + i]->occluded_local(local_rays[i], t_min, t_max))
+                                return true;
+                    }
+
+                    continue;
+                }
+
+                uint32_t near_child = node.m_left_first;
+                uint32_t far_child = node.m_left_first + 1;
+
+                float near_t = m_nodes[near_child].m_bounds.intersects(ray.m_origin, inv_dir, t_max);
+                float far_t = m_nodes[far_child].m_bounds.intersects(ray.m_origin, inv_dir, t_max);
+
+                if (far_t < near_t)
+                {
+                    std::swap(near_child, far_child);
+                    std::swap(near_t, far_t);
+                }
+
+                if (far_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = far_child;
+                }
+
+                if (near_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = near_child;
+                }
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Closest hit of every active ray of a coherent packet, the packet is traversed as a whole
+         *
+         * Every stack entry carries the mask of rays that entered the node, so rays drop out of subtrees they miss
+         * while the others keep going. The boxes are tested simd::kWidth rays at a time.
+         *
+         * @param packet The rays in world space
+         * @param t_min Lower bound of the interval
+         * @param hits In: m_t is the upper bound of each ray. Out: the nearest hits that were found
+         */
+        void closest_hit(const RayPacket &packet, const float t_min, PacketHits &hits) const
+        {
+            PROFILE_FUNCTION();
+
+            if (m_nodes.empty() || packet.m_active == 0)
+                return;
+
+            struct StackEntry
+            {
+                uint32_t m_node;
+                uint32_t m_mask;
+                float m_t;
+            };
+
+            StackEntry stack[kStackSize];
+            int stack_ptr = 0;
+
+            float root_t = std::numeric_limits<float>::infinity();
+            const uint32_t root_mask = packet.intersects(m_nodes[0].m_bounds, packet.m_active, hits.m_t, root_t);
+
+            if (root_mask == 0)
+                return;
+
+            stack[stack_ptr++] = {0, root_mask, root_t};
+
+            while (stack_ptr > 0)
+            {
+                const StackEntry entry = stack[--stack_ptr];
+
+                // rays that already hit something in front of the node can't find a closer hit inside it
+                uint32_t mask = 0;
+
+                for (uint32_t rays = entry.m_mask; rays != 0; rays &= rays - 1)
+                {
+                    const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                    if (hits.m_t[ray] > entry.m_t)
+                        mask |= 1u << ray;
+                }
+
+                if (mask == 0)
+                    continue;
+
+                const BVHNode &node = m_nodes[entry.m_node];
+
+                if (node.is_leaf())
+                {
+                    // m_inverse_transforms is laid out for one ray against many shapes, a packet leaf is many rays
+                    // against a few shapes, where it measured slower than the matrix each shape keeps
+                    for (uint32_t i = node.m_left_first; i < node.m_left_first + node.m_count; i++)
+                    {
+                        const Shape &shape = *m_shapes[i];
+                        const Matrix4 &inverse_transform = shape.get_inverse_transform();
+
+                        for (uint32_t rays = mask; rays != 0; rays &= rays - 1)
+                        {
+                            const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                            Hit hit = hits[ray];
+
+                            if (shape.closest_hit_local(packet.m_rays[ray].transform(inverse_transform), t_min, hit))
+                                hits.update(ray, hit.m_t, hit.m_object, hit.m_primitive);
+                        }
+                    }
+
+                    continue;
+                }
+
+                uint32_t near_child = node.m_left_first;
+                uint32_t far_child = node.m_left_first + 1;
+
+                float near_t = std::numeric_limits<float>::infinity();
+                float far_t = std::numeric_limits<float>::infinity();
+
+                uint32_t near_mask = packet.intersects(m_nodes[near_child].m_bounds, mask, hits.m_t, near_t);
+                uint32_t far_mask = packet.intersects(m_nodes[far_child].m_bounds, mask, hits.m_t, far_t);
+
+                if (far_t < near_t)
+                {
+                    std::swap(near_child, far_child);
+                    std::swap(near_t, far_t);
+                    std::swap(near_mask, far_mask);
+                }
+
+                // push the far child first so the near one is popped next
+                if (far_mask != 0)
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = {far_child, far_mask, far_t};
+                }
+
+                if (near_mask != 0)
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = {near_child, near_mask, near_t};
+                }
+            }
+        }
+
+        /**
+         * @brief Which rays of a coherent packet (shadow rays towards one light) hit a shape inside (t_min, m_t_max)
+         *
+         * The packet counterpart of occluded: children are visited near first with the mask of rays that entered
+         * them, and a ray drops out of the traversal as soon as it is blocked. Returns once every ray is.
+         *
+         * @param packet The rays in world space, m_t_max is the upper bound of each ray (its light distance)
+         * @param t_min Lower bound of the interval
+         * @return uint32_t The rays of packet.m_active that are blocked
+         */
+        [[nodiscard]] uint32_t occluded(const RayPacket &packet, const float t_min) const
+        {
+            PROFILE_FUNCTION();
+
+            if (m_nodes.empty() || packet.m_active == 0)
+                return 0;
+
+            struct StackEntry
+            {
+                uint32_t m_node;
+                uint32_t m_mask;
+            };
+
+            StackEntry stack[kStackSize];
+            int stack_ptr = 0;
+
+            float root_t = std::numeric_limits<float>::infinity();
+            const uint32_t root_mask = packet.intersects(m_nodes[0].m_bounds, packet.m_active, packet.m_t_max, root_t);
+
+            if (root_mask == 0)
+                return 0;
+
+            uint32_t blocked = 0;
+
+            stack[stack_ptr++] = {0, root_mask};
+
+            while (stack_ptr > 0)
+            {
+                const StackEntry entry = stack[--stack_ptr];
+                const uint32_t mask = entry.m_mask & ~blocked;
+
+                if (mask == 0)
+                    continue;
+
+                const BVHNode &node = m_nodes[entry.m_node];
+
+                if (node.is_leaf())
+                {
+                    for (uint32_t i = node.m_left_first; i < node.m_left_first + node.m_count; i++)
+                    {
+                        const Shape &shape = *m_shapes[i];
+                        const Matrix4 &inverse_transform = shape.get_inverse_transform();
+
+                        for (uint32_t rays = mask & ~blocked; rays != 0; rays &= rays - 1)
+                        {
+                            const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                            if (shape.occluded_local(packet.m_rays[ray].transform(inverse_transform), t_min, packet.m_t_max[ray]))
+                                blocked |= 1u << ray;
+                        }
+                    }
+
+                    if (blocked == packet.m_active)
+                        return blocked;
+
+                    continue;
+                }
+
+                uint32_t near_child = node.m_left_first;
+                uint32_t far_child = node.m_left_first + 1;
+
+                float near_t = std::numeric_limits<float>::infinity();
+                float far_t = std::numeric_limits<float>::infinity();
+
+                uint32_t near_mask = packet.intersects(m_nodes[near_child].m_bounds, mask, packet.m_t_max, near_t);
+                uint32_t far_mask = packet.intersects(m_nodes[far_child].m_bounds, mask, packet.m_t_max, far_t);
+
+                if (far_t < near_t)
+                {
+                    std::swap(near_child, far_child);
+                    std::swap(near_mask, far_mask);
+                }
+
+                if (far_mask != 0)
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = {far_child, far_mask};
+                }
+
+                if (near_mask != 0)
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = {near_child, near_mask};
+                }
+            }
+
+            return blocked;
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_nodes.empty();
+        }
+
+        [[nodiscard]] const std::vector<BVHNode> &get_nodes() const noexcept
+        {
+            return m_nodes;
+        }
+
+        [[nodiscard]] const std::vector<Shape *> &get_shapes() const noexcept
+        {
+            return m_shapes;
+        }
+
+    private:
+        std::vector<BVHNode> m_nodes;
+        std::vector<Shape *> m_shapes;
+        TransformBatch m_inverse_transforms; // indexed like m_shapes
+    };
+} // namespace Karbon
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "Acceleration/AABB.hpp"
+#include "Constants.hpp"
+#include "Tuples/Point.hpp"
+
+namespace Karbon
+{
+    struct BVHNode
+    {
+        [[nodiscard]] constexpr bool is_leaf() const noexcept
+        {
+            return m_count > 0;
+        }
+
+        AABB m_bounds;
+        uint32_t m_left_first = 0; // index of the left child for inner nodes (right child is m_left_first + 1), first primitive for leaves
+        uint32_t m_count = 0;      // number of primitives in a leaf, 0 for inner nodes
+    };
+
+    // relative costs the SAH weighs a split with, the leaf size it splits regardless of cost and the deepest a node may
+    // sit below the root (traversal keeps at most depth + 1 nodes on its stack, so this bounds the stack it needs)
+    struct BVHBuildSettings
+    {
+        float m_traversal_cost = 1.0f;
+        float m_intersection_cost = 1.0f;
+        uint32_t m_max_leaf_size = 4;
+        uint32_t m_max_depth = 63;
+    };
+
+    /**
+     * @brief Top-down binned SAH builder shared by BVH (over shapes) and TriangleBVH (over triangles)
+     *
+     * Nodes go into a flat array with siblings next to each other, and the primitives are partitioned in place so
+     * every leaf covers a contiguous range of them. The builder only sees the primitive bounds, every exchange of the
+     * partition is also passed to `swap(i, j)` so the owner reorders its own primitive data the same way.
+     */
+    template <typename Swap>
+    struct BVHBuilder
+    {
+        static constexpr int kBinCount = 12;
+
+        /**
+         * @param nodes Receives the nodes, the root is nodes[0]
+         * @param bounds Bounds of every primitive
+         * @param settings SAH costs and leaf size
+         * @param swap Called as swap(i, j) whenever primitives i and j trade places
+         */
+        [[nodiscard]] BVHBuilder(std::vector<BVHNode> &nodes, std::vector<AABB> bounds, const BVHBuildSettings &settings, Swap swap)
+            : m_nodes(nodes), m_bounds(std::move(bounds)), m_settings(settings), m_swap(std::move(swap))
+        {
+        }
+
+        void build()
+        {
+            m_nodes.clear();
+
+            if (m_bounds.empty())
+                return;
+
+            m_centroids.clear();
+            m_centroids.reserve(m_bounds.size());
+
+            for (const auto &box : m_bounds)
+                m_centroids.emplace_back(box.centroid());
+
+            m_nodes.reserve(m_bounds.size() * 2);
+            m_nodes.emplace_back();
+            m_nodes[0].m_left_first = 0;
+            m_nodes[0].m_count = (uint32_t)m_bounds.size();
+
+            update_bounds(0);
+            subdivide(0, 0);
+        }
+
+    private:
+        struct Bin
+        {
+            AABB m_bounds;
+            uint32_t m_count = 0;
+        };
+
+        void update_bounds(const uint32_t node_index)
+        {
+            BVHNode &node = m_nodes[node_index];
+
+            node.m_bounds = AABB();
+
+            for (uint32_t i = node.m_left_first; i < node.m_left_first + node.m_count; i++)
+                node.m_bounds.expand(m_bounds[i]);
+        }
+
+        // finds the cheapest binned split, returns the cost and writes the split axis/position
+        [[nodiscard]] float find_best_split(const BVHNode &node, int &best_axis, float &best_position) const
+        {
+            AABB centroid_bounds;
+
+            for (uint32_t i = node.m_left_first; i < node.m_left_first + node.m_count; i++)
+                centroid_bounds.expand(m_centroids[i]);
+
+            float best_cost = std::numeric_limits<float>::infinity();
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const float bounds_min = centroid_bounds.m_min[(char)axis];
+                const float bounds_max = centroid_bounds.m_max[(char)axis];
+
+                if (bounds_min == bounds_max)
+                    continue;
+
+                Bin bins[kBinCount];
+                const float scale = (float)kBinCount / (bounds_max - bounds_min);
+
+                for (uint32_t i = node.m_left_first; i < node.m_left_first + node.m_count; i++)
+                {
+                    int bin_index = std::min(kBinCount - 1, (int)((m_centroids[i][(char)axis] - bounds_min) * scale));
+                    bins[bin_index].m_count++;
+                    bins[bin_index].m_bounds.expand(m_bounds[i]);
+                }
+
+                // sweep from both sides to get the area and count left/right of every plane
+                float left_area[kBinCount - 1];
+                float right_area[kBinCount - 1];
+                uint32_t left_count[kBinCount - 1];
+                uint32_t right_count[kBinCount - 1];
+
+                AABB left_box;
+                AABB right_box;
+                uint32_t left_sum = 0;
+                uint32_t right_sum = 0;
+
+                for (int i = 0; i < kBinCount - 1; i++)
+                {
+                    left_sum += bins[i].m_count;
+                    left_count[i] = left_sum;
+                    left_box.expand(bins[i].m_bounds);
+                    left_area[i] = left_box.surface_area();
+
+                    right_sum += bins[kBinCount - 1 - i].m_count;
+                    right_count[kBinCount - 2 - i] = right_sum;
+                    right_box.expand(bins[kBinCount - 1 - i].m_bounds);
+                    right_area[kBinCount - 2 - i] = right_box.surface_area();
+                }
+
+                for (int i = 0; i < kBinCount - 1; i++)
+                {
+                    if (left_count[i] == 0 || right_count[i] == 0)
+                        continue;
+
+                    float cost = (float)left_count[i] * left_area[i] + (float)right_count[i] * right_area[i];
+
+                    if (cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_position = bounds_min + (float)(i + 1) / scale;
+                    }
+                }
+            }
+
+            return best_cost;
+        }
+
+        void subdivide(const uint32_t node_index, const uint32_t depth)
+        {
+            BVHNode &node = m_nodes[node_index];
+
+            // past the depth limit the node stays a (possibly large) leaf, only degenerate inputs get here
+            if (node.m_count <= 1 || depth >= m_settings.m_max_depth)
+                return;
+
+            int axis = -1;
+            float split_position = 0;
+
+            const float parent_area = node.m_bounds.surface_area();
+            const float split_cost = find_best_split(node, axis, split_position);
+            const float leaf_cost = (float)node.m_count * m_settings.m_intersection_cost;
+
+            // a split has to pay for the extra traversal step, otherwise keep the leaf (when it is small enough)
+            bool should_split = axis != -1 && (node.m_count > m_settings.m_max_leaf_size || m_settings.m_traversal_cost + m_settings.m_intersection_cost * split_cost / parent_area < leaf_cost);
+
+            if (!should_split)
+                return;
+
+            // in-place partition of the primitives and their build data
+            uint32_t i = node.m_left_first;
+            uint32_t j = node.m_left_first + node.m_count - 1;
+
+            while (i <= j && j != std::numeric_limits<uint32_t>::max())
+            {
+                if (m_centroids[i][(char)axis] < split_position)
+                    i++;
+                else
+                {
+                    m_swap(i, j);
+                    std::swap(m_bounds[i], m_bounds[j]);
+                    std::swap(m_centroids[i], m_centroids[j]);
+                    j--;
+                }
+            }
+
+            uint32_t left_count = i - node.m_left_first;
+
+            if (left_count == 0 || left_count == node.m_count)
+                return;
+
+            uint32_t left_child = (uint32_t)m_nodes.size();
+
+            m_nodes.emplace_back();
+            m_nodes.emplace_back();
+
+            // emplace_back may have reallocated, don't keep using the old reference
+            BVHNode &parent = m_nodes[node_index];
+
+            m_nodes[left_child].m_left_first = parent.m_left_first;
+            m_nodes[left_child].m_count = left_count;
+            m_nodes[left_child + 1].m_left_first = i;
+            m_nodes[left_child + 1].m_count = parent.m_count - left_count;
+
+            parent.m_left_first = left_child;
+            parent.m_count = 0;
+
+            update_bounds(left_child);
+            update_bounds(left_child + 1);
+
+            subdivide(left_child, depth + 1);
+            subdivide(left_child + 1, depth + 1);
+        }
+
+        std::vector<BVHNode> &m_nodes;
+        std::vector<AABB> m_bounds;     // indexed like the primitives, reordered along with them
+        std::vector<Point> m_centroids; // same
+        BVHBuildSettings m_settings;
+        Swap m_swap;
+    };
+} // namespace Karbon
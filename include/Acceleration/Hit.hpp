@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Constants.hpp"
+
+namespace Karbon
+{
+    struct Shape;
+
+    /**
+     * @brief Result of a closest-hit query, a single record instead of the full intersection list
+     *
+     */
+    struct Hit
+    {
+        [[nodiscard]] constexpr bool is_valid() const noexcept
+        {
+            return m_object != nullptr;
+        }
+
+        float m_t = std::numeric_limits<float>::infinity();
+        Shape *m_object = nullptr;
+        uint32_t m_primitive = 0; // the triangle of a TriangleMesh, 0 for the other shapes
+    };
+} // namespace Karbon
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "Acceleration/AABB.hpp"
+#include "Acceleration/Hit.hpp"
+#include "Constants.hpp"
+#include "Ray.hpp"
+#include "Simd.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief A group of coherent rays (a 4x4 block of camera rays, or shadow rays towards one light) traced together
+     *
+     * Besides the rays themselves the origins and inverse directions are kept as structure-of-arrays so one box test
+     * covers simd::kWidth rays. Rays that are not part of the packet (image borders) have their bit cleared in m_active.
+     */
+    struct RayPacket
+    {
+        static constexpr uint32_t kSide = 4;
+        static constexpr uint32_t kSize = kSide * kSide;
+
+        static_assert(kSize % simd::kWidth == 0, "a packet has to fill whole simd groups");
+
+        [[nodiscard]] RayPacket()
+        {
+            clear();
+        }
+
+        // removes every ray, the padding lanes get rays that can't hit anything
+        void clear() noexcept
+        {
+            m_active = 0;
+
+            for (uint32_t i = 0; i < kSize; i++)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    m_origin[axis][i] = 0;
+                    m_inverse_direction[axis][i] = std::numeric_limits<float>::infinity();
+                }
+
+                m_t_max[i] = -std::numeric_limits<float>::infinity();
+            }
+        }
+
+        // puts `ray` into slot `index`, hits farther than t_max are ignored (the light distance for shadow rays)
+        void set(const uint32_t index, const Ray &ray, const float t_max = std::numeric_limits<float>::infinity()) noexcept
+        {
+            assert(index < kSize);
+
+            const Vector inv_dir = inverse_direction(ray.m_direction);
+
+            m_rays[index] = ray;
+            m_origin[0][index] = ray.m_origin.x;
+            m_origin[1][index] = ray.m_origin.y;
+            m_origin[2][index] = ray.m_origin.z;
+            m_inverse_direction[0][index] = inv_dir.x;
+            m_inverse_direction[1][index] = inv_dir.y;
+            m_inverse_direction[2][index] = inv_dir.z;
+            m_t_max[index] = t_max;
+
+            m_active |= 1u << index;
+        }
+
+        [[nodiscard]] uint32_t count() const noexcept
+        {
+            return (uint32_t)std::popcount(m_active);
+        }
+
+        /**
+         * @brief Slab test of every ray in `mask` against the box
+         *
+         * @param box The box to test
+         * @param mask The rays to test
+         * @param t_max Per ray upper bound of the interval (the closest hit so far)
+         * @param t_entry Lowered to the smallest entry distance of the rays that hit the box
+         * @return uint32_t The rays of `mask` that hit the box
+         */
+        [[nodiscard]] uint32_t intersects(const AABB &box, const uint32_t mask, const float (&t_max)[kSize], float &t_entry) const noexcept
+        {
+            const simd::FloatLanes min_x = simd::FloatLanes::broadcast(box.m_min.x);
+            const simd::FloatLanes min_y = simd::FloatLanes::broadcast(box.m_min.y);
+            const simd::FloatLanes min_z = simd::FloatLanes::broadcast(box.m_min.z);
+            const simd::FloatLanes max_x = simd::FloatLanes::broadcast(box.m_max.x);
+            const simd::FloatLanes max_y = simd::FloatLanes::broadcast(box.m_max.y);
+            const simd::FloatLanes max_z = simd::FloatLanes::broadcast(box.m_max.z);
+            const simd::FloatLanes zero = simd::FloatLanes::broadcast(0);
+
+            uint32_t hits = 0;
+
+            for (uint32_t first = 0; first < kSize; first += simd::kWidth)
+            {
+                if (((mask >> first) & simd::first_lanes(simd::kWidth)) == 0)
+                    continue;
+
+                const simd::FloatLanes ox = simd::FloatLanes::load(m_origin[0] + first);
+                const simd::FloatLanes oy = simd::FloatLanes::load(m_origin[1] + first);
+                const simd::FloatLanes oz = simd::FloatLanes::load(m_origin[2] + first);
+                const simd::FloatLanes ix = simd::FloatLanes::load(m_inverse_direction[0] + first);
+                const simd::FloatLanes iy = simd::FloatLanes::load(m_inverse_direction[1] + first);
+                const simd::FloatLanes iz = simd::FloatLanes::load(m_inverse_direction[2] + first);
+
+                const simd::FloatLanes tx1 = (min_x - ox) * ix;
+                const simd::FloatLanes tx2 = (max_x - ox) * ix;
+                const simd::FloatLanes ty1 = (min_y - oy) * iy;
+                const simd::FloatLanes ty2 = (max_y - oy) * iy;
+                const simd::FloatLanes tz1 = (min_z - oz) * iz;
+                const simd::FloatLanes tz2 = (max_z - oz) * iz;
+
+                const simd::FloatLanes t_near = simd::max(simd::min(tx1, tx2), simd::max(simd::min(ty1, ty2), simd::min(tz1, tz2)));
+                const simd::FloatLanes t_far = simd::min(simd::max(tx1, tx2), simd::min(simd::max(ty1, ty2), simd::max(tz1, tz2)));
+
+                // same acceptance as AABB::intersects
+                const simd::MaskLanes hit = (t_far >= t_near) & (t_far > zero) & (t_near < simd::FloatLanes::load(t_max + first));
+                const uint32_t group_hits = hit.bits() & (mask >> first);
+
+                if (group_hits == 0)
+                    continue;
+
+                hits |= group_hits << first;
+
+                float near_values[simd::kWidth];
+                t_near.store(near_values);
+
+                for (uint32_t lanes = group_hits; lanes != 0; lanes &= lanes - 1)
+                    t_entry = std::min(t_entry, near_values[std::countr_zero(lanes)]);
+            }
+
+            return hits;
+        }
+
+        Ray m_rays[kSize];
+
+        float m_origin[3][kSize];
+        float m_inverse_direction[3][kSize];
+        float m_t_max[kSize];
+
+        uint32_t m_active = 0; // bit i is set when slot i holds a ray
+    };
+
+    // closest hits of every ray in a packet, m_t doubles as the per ray upper bound during traversal
+    struct PacketHits
+    {
+        [[nodiscard]] const Hit &operator[](const uint32_t index) const noexcept
+        {
+            return m_hits[index];
+        }
+
+        [[nodiscard]] Hit &operator[](const uint32_t index) noexcept
+        {
+            return m_hits[index];
+        }
+
+        void reset(const RayPacket &packet) noexcept
+        {
+            for (uint32_t i = 0; i < RayPacket::kSize; i++)
+            {
+                m_hits[i] = Hit();
+                m_hits[i].m_t = packet.m_t_max[i];
+                m_t[i] = packet.m_t_max[i];
+            }
+        }
+
+        // keep m_t in sync after changing a hit
+        void update(const uint32_t index, const float t, Shape *object, const uint32_t primitive = 0) noexcept
+        {
+            m_hits[index].m_t = t;
+            m_hits[index].m_object = object;
+            m_hits[index].m_primitive = primitive;
+            m_t[index] = t;
+        }
+
+        Hit m_hits[RayPacket::kSize];
+        float m_t[RayPacket::kSize]; // copy of the hit distances laid out for the simd box tests
+    };
+} // namespace Karbon
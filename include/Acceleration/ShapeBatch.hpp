@@ -0,0 +1,220 @@
+#pragma once
+
+#include "Acceleration/Hit.hpp"
+#include "Acceleration/TransformBatch.hpp"
+#include "Constants.hpp"
+#include "Ray.hpp"
+#include "Shapes/Cube.hpp"
+#include "Shapes/Shape.hpp"
+#include "Shapes/Sphere.hpp"
+#include "Simd.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief Shapes of one kind packed for wide intersection tests
+     *
+     * Instead of a virtual call per shape, the inverse transforms are kept in a TransformBatch and `Kernel` intersects
+     * one ray with simd::kWidth shapes at once in object space. The shapes themselves are only touched to report a hit.
+     *
+     * A Kernel has `static simd::FloatLanes intersect(const simd::FloatLanes (&origin)[3], const simd::FloatLanes
+     * (&direction)[3], simd::MaskLanes &valid)` returning the same distance the shape's intersects_local would, with
+     * `valid` cleared in the lanes that miss.
+     *
+     * @tparam Kernel The wide intersection routine of the shape kind
+     */
+    template <typename Kernel>
+    struct ShapeBatch
+    {
+        static constexpr uint32_t kWidth = simd::kWidth;
+
+        [[nodiscard]] ShapeBatch() = default;
+
+        void clear()
+        {
+            m_shapes.clear();
+            m_inverse_transforms.clear();
+        }
+
+        void push_back(Shape *shape)
+        {
+            m_shapes.emplace_back(shape);
+            m_inverse_transforms.push_back(shape->get_inverse_transform());
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return m_shapes.size();
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_shapes.empty();
+        }
+
+        /**
+         * @brief Collects every positive intersection along the ray (unsorted)
+         *
+         * @param ray The ray in world space
+         * @param xs Intersections are appended to this vector
+         */
+        void intersects(const Ray &ray, std::vector<std::pair<float, Shape *>> &xs) const
+        {
+            const uint32_t size = (uint32_t)m_shapes.size();
+
+            for (uint32_t first = 0; first < size; first += kWidth)
+            {
+                float t[kWidth];
+                uint32_t hits = test(ray, first, simd::FloatLanes::broadcast(0), simd::FloatLanes::broadcast(std::numeric_limits<float>::infinity()), t);
+
+                for (; hits != 0; hits &= hits - 1)
+                {
+                    const uint32_t lane = (uint32_t)std::countr_zero(hits);
+                    xs.emplace_back(t[lane], m_shapes[first + lane]);
+                }
+            }
+        }
+
+        /**
+         * @brief Finds the nearest intersection inside (t_min, hit.m_t)
+         *
+         * @param ray The ray in world space
+         * @param t_min Lower bound of the interval
+         * @param hit In: m_t is the upper bound of the interval. Out: the nearest hit if one was found
+         * @return true if the hit was updated
+         */
+        bool closest_hit(const Ray &ray, const float t_min, Hit &hit) const
+        {
+            const uint32_t size = (uint32_t)m_shapes.size();
+            const simd::FloatLanes lower = simd::FloatLanes::broadcast(t_min);
+
+            bool found = false;
+
+            for (uint32_t first = 0; first < size; first += kWidth)
+            {
+                float t[kWidth];
+                uint32_t hits = test(ray, first, lower, simd::FloatLanes::broadcast(hit.m_t), t);
+
+                for (; hits != 0; hits &= hits - 1)
+                {
+                    const uint32_t lane = (uint32_t)std::countr_zero(hits);
+
+                    if (t[lane] < hit.m_t)
+                    {
+                        hit.m_t = t[lane];
+                        hit.m_object = m_shapes[first + lane];
+                        hit.m_primitive = 0;
+                        found = true;
+                    }
+                }
+            }
+
+            return found;
+        }
+
+        // true if any shape is hit inside (t_min, t_max), stops at the first group with a hit
+        [[nodiscard]] bool occluded(const Ray &ray, const float t_min, const float t_max) const
+        {
+            const uint32_t size = (uint32_t)m_shapes.size();
+            const simd::FloatLanes lower = simd::FloatLanes::broadcast(t_min);
+            const simd::FloatLanes upper = simd::FloatLanes::broadcast(t_max);
+
+            for (uint32_t first = 0; first < size; first += kWidth)
+            {
+                float t[kWidth];
+
+                if (test(ray, first, lower, upper, t) != 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+    private:
+        // intersects the group starting at `first`, returns one bit per lane hit inside (lower, upper)
+        [[nodiscard]] uint32_t test(const Ray &ray, const uint32_t first, const simd::FloatLanes lower, const simd::FloatLanes upper, float (&t)[kWidth]) const noexcept
+        {
+            simd::FloatLanes origin[3];
+            simd::FloatLanes direction[3];
+
+            m_inverse_transforms.transform(ray, first, origin, direction);
+
+            simd::MaskLanes valid;
+            const simd::FloatLanes distance = Kernel::intersect(origin, direction, valid);
+
+            valid = valid & (distance > lower) & (distance < upper);
+
+            const uint32_t hits = valid.bits() & simd::first_lanes((uint32_t)m_shapes.size() - first);
+
+            if (hits != 0)
+                distance.store(t);
+
+            return hits;
+        }
+
+        std::vector<Shape *> m_shapes;
+        TransformBatch m_inverse_transforms; // indexed like m_shapes
+    };
+
+    // wide version of Sphere::intersects_local, a unit sphere at the origin
+    struct SphereKernel
+    {
+        [[nodiscard]] static simd::FloatLanes intersect(const simd::FloatLanes (&origin)[3], const simd::FloatLanes (&direction)[3], simd::MaskLanes &valid) noexcept
+        {
+            const simd::FloatLanes zero = simd::FloatLanes::broadcast(0);
+
+            const simd::FloatLanes a = direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2];
+            const simd::FloatLanes b = simd::FloatLanes::broadcast(2) * (origin[0] * direction[0] + origin[1] * direction[1] + origin[2] * direction[2]);
+            const simd::FloatLanes c = origin[0] * origin[0] + origin[1] * origin[1] + origin[2] * origin[2] - simd::FloatLanes::broadcast(1);
+
+            const simd::FloatLanes discriminant = b * b - simd::FloatLanes::broadcast(4) * a * c;
+            const simd::FloatLanes root = simd::sqrt(simd::max(discriminant, zero));
+            const simd::FloatLanes two_a = a + a;
+
+            const simd::FloatLanes t1 = (zero - b - root) / two_a;
+            const simd::FloatLanes t2 = (zero - b + root) / two_a;
+
+            const simd::FloatLanes t = simd::select(t1 < zero, t2, t1);
+
+            valid = (discriminant >= zero) & (t >= zero);
+
+            return t;
+        }
+    };
+
+    // wide version of Cube::intersects_local, the box from (-1, -1, -1) to (1, 1, 1)
+    struct CubeKernel
+    {
+        [[nodiscard]] static simd::FloatLanes intersect(const simd::FloatLanes (&origin)[3], const simd::FloatLanes (&direction)[3], simd::MaskLanes &valid) noexcept
+        {
+            const simd::FloatLanes one = simd::FloatLanes::broadcast(1);
+            const simd::FloatLanes epsilon = simd::FloatLanes::broadcast((float)kEpsilon);
+            const simd::FloatLanes infinity = simd::FloatLanes::broadcast(std::numeric_limits<float>::infinity());
+
+            simd::FloatLanes t_near = simd::FloatLanes::broadcast(-std::numeric_limits<float>::infinity());
+            simd::FloatLanes t_far = infinity;
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                const simd::FloatLanes min_numerator = simd::FloatLanes::broadcast(-1) - origin[axis];
+                const simd::FloatLanes max_numerator = one - origin[axis];
+
+                // a (nearly) parallel axis pushes the slab to +-infinity, like check_axis in Cube
+                const simd::MaskLanes parallel = simd::abs(direction[axis]) < epsilon;
+
+                const simd::FloatLanes t0 = simd::select(parallel, min_numerator * infinity, min_numerator / direction[axis]);
+                const simd::FloatLanes t1 = simd::select(parallel, max_numerator * infinity, max_numerator / direction[axis]);
+
+                t_near = simd::max(t_near, simd::min(t0, t1));
+                t_far = simd::min(t_far, simd::max(t0, t1));
+            }
+
+            valid = t_near <= t_far;
+
+            return t_near;
+        }
+    };
+
+    using SphereBatch = ShapeBatch<SphereKernel>;
+    using CubeBatch = ShapeBatch<CubeKernel>;
+} // namespace Karbon
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "Matrix.hpp"
+#include "Ray.hpp"
+#include "Simd.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief The inverse transforms of many shapes, stored so one ray can be moved into several object spaces at once
+     *
+     * Structure of arrays: coefficient k (row-major over the top 3 rows) of every transform is contiguous, so a kernel
+     * broadcasts the ray once and handles kWidth transforms per iteration. The arrays are padded by kWidth zeros so a
+     * group starting at any index can be loaded without bounds checks.
+     */
+    struct TransformBatch
+    {
+        static constexpr uint32_t kWidth = simd::kWidth;
+
+        // number of coefficients of a 3x4 affine transform
+        static constexpr int kCoefficients = 12;
+
+        [[nodiscard]] TransformBatch() = default;
+
+        void clear()
+        {
+            m_size = 0;
+
+            for (auto &coefficient : m_coefficients)
+                coefficient.assign(kWidth, 0.0f);
+        }
+
+        void reserve(const size_t size)
+        {
+            for (auto &coefficient : m_coefficients)
+                coefficient.reserve(size + kWidth);
+        }
+
+        // append a transform, the bottom row of the matrix is assumed to be (0, 0, 0, 1)
+        void push_back(const Matrix4 &matrix)
+        {
+            for (int k = 0; k < kCoefficients; k++)
+            {
+                auto &coefficient = m_coefficients[(size_t)k];
+
+                coefficient.resize(m_size + 1 + kWidth, 0.0f);
+                coefficient[m_size] = matrix(k / 4, k % 4);
+            }
+
+            m_size++;
+        }
+
+        [[nodiscard]] uint32_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        /**
+         * @brief Transforms `ray` by the kWidth transforms starting at `first`, the result stays in registers
+         *
+         * Lanes past size() hold the zero padding and give a zero ray, callers mask them out.
+         *
+         * @param ray The ray in world space
+         * @param first Index of the first transform
+         * @param origin x, y, z of the local origins
+         * @param direction x, y, z of the local directions
+         */
+        void transform(const Ray &ray, const uint32_t first, simd::FloatLanes (&origin)[3], simd::FloatLanes (&direction)[3]) const noexcept
+        {
+            assert(first < m_size);
+
+            const simd::FloatLanes ox = simd::FloatLanes::broadcast(ray.m_origin.x);
+            const simd::FloatLanes oy = simd::FloatLanes::broadcast(ray.m_origin.y);
+            const simd::FloatLanes oz = simd::FloatLanes::broadcast(ray.m_origin.z);
+            const simd::FloatLanes dx = simd::FloatLanes::broadcast(ray.m_direction.x);
+            const simd::FloatLanes dy = simd::FloatLanes::broadcast(ray.m_direction.y);
+            const simd::FloatLanes dz = simd::FloatLanes::broadcast(ray.m_direction.z);
+
+            for (int row = 0; row < 3; row++)
+            {
+                const simd::FloatLanes m0 = simd::FloatLanes::load(m_coefficients[(size_t)(row * 4 + 0)].data() + first);
+                const simd::FloatLanes m1 = simd::FloatLanes::load(m_coefficients[(size_t)(row * 4 + 1)].data() + first);
+                const simd::FloatLanes m2 = simd::FloatLanes::load(m_coefficients[(size_t)(row * 4 + 2)].data() + first);
+                const simd::FloatLanes m3 = simd::FloatLanes::load(m_coefficients[(size_t)(row * 4 + 3)].data() + first);
+
+                origin[row] = (m0 * ox + m1 * oy) + (m2 * oz + m3);
+                direction[row] = (m0 * dx + m1 * dy) + m2 * dz;
+            }
+        }
+
+        /**
+         * @brief Transforms `ray` by the transforms [first, first + count)
+         *
+         * @param ray The ray in world space
+         * @param first Index of the first transform
+         * @param count Number of transforms, at most kWidth
+         * @param out out[i] is the ray in the space of transform first + i
+         */
+        void transform(const Ray &ray, const uint32_t first, const uint32_t count, Ray *out) const noexcept
+        {
+            assert(count <= kWidth && first + count <= m_size);
+
+            simd::FloatLanes origin[3];
+            simd::FloatLanes direction[3];
+
+            transform(ray, first, origin, direction);
+
+            float result[6][kWidth];
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                origin[axis].store(result[axis]);
+                direction[axis].store(result[axis + 3]);
+            }
+
+            for (uint32_t i = 0; i < count; i++)
+                out[i] = Ray(Point(result[0][i], result[1][i], result[2][i]), Vector(result[3][i], result[4][i], result[5][i]));
+        }
+
+    private:
+        std::array<std::vector<float>, kCoefficients> m_coefficients;
+        uint32_t m_size = 0;
+    };
+} // namespace Karbon
@@ -0,0 +1,314 @@
+#pragma once
+
+#include "Acceleration/AABB.hpp"
+#include "Acceleration/BVHBuilder.hpp"
+#include "Constants.hpp"
+#include "Ray.hpp"
+#include "Tuples/Point.hpp"
+#include "Tuples/Vector.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief A ray prepared for the watertight ray/triangle test of Woop, Benthin and Wald
+     *
+     * The ray is turned into the +z axis by permuting the axes (z becomes the largest direction component) and
+     * shearing, so every triangle test reduces to 2D edge functions around the origin. Edges shared by two triangles
+     * give the same edge function value in both, a ray can't slip through the crack between them.
+     */
+    struct WatertightRay
+    {
+        [[nodiscard]] explicit WatertightRay(const Ray &ray) noexcept
+        {
+            m_origin[0] = ray.m_origin.x;
+            m_origin[1] = ray.m_origin.y;
+            m_origin[2] = ray.m_origin.z;
+
+            const float direction[3] = {ray.m_direction.x, ray.m_direction.y, ray.m_direction.z};
+
+            m_kz = std::abs(direction[0]) > std::abs(direction[1]) ? (std::abs(direction[0]) > std::abs(direction[2]) ? 0 : 2) : (std::abs(direction[1]) > std::abs(direction[2]) ? 1 : 2);
+            m_kx = (m_kz + 1) % 3;
+            m_ky = (m_kx + 1) % 3;
+
+            // keep the winding of the triangles
+            if (direction[m_kz] < 0)
+                std::swap(m_kx, m_ky);
+
+            m_shear_x = direction[m_kx] / direction[m_kz];
+            m_shear_y = direction[m_ky] / direction[m_kz];
+            m_shear_z = 1.0f / direction[m_kz];
+        }
+
+        /**
+         * @brief Distance to the triangle (p0, p1, p2) along the ray if it is inside (t_min, t_max)
+         *
+         * @return float The distance, infinity if the ray misses or the hit is outside the interval
+         */
+        [[nodiscard]] float intersect(const Point &p0, const Point &p1, const Point &p2, const float t_min, const float t_max) const noexcept
+        {
+            const float a[3] = {p0.x - m_origin[0], p0.y - m_origin[1], p0.z - m_origin[2]};
+            const float b[3] = {p1.x - m_origin[0], p1.y - m_origin[1], p1.z - m_origin[2]};
+            const float c[3] = {p2.x - m_origin[0], p2.y - m_origin[1], p2.z - m_origin[2]};
+
+            const float ax = a[m_kx] - m_shear_x * a[m_kz];
+            const float ay = a[m_ky] - m_shear_y * a[m_kz];
+            const float bx = b[m_kx] - m_shear_x * b[m_kz];
+            const float by = b[m_ky] - m_shear_y * b[m_kz];
+            const float cx = c[m_kx] - m_shear_x * c[m_kz];
+            const float cy = c[m_ky] - m_shear_y * c[m_kz];
+
+            float u = cx * by - cy * bx;
+            float v = ax * cy - ay * cx;
+            float w = bx * ay - by * ax;
+
+            // exactly on an edge in float, only double precision can tell which side it is
+            if (u == 0.0f || v == 0.0f || w == 0.0f)
+            {
+                u = (float)((double)cx * (double)by - (double)cy * (double)bx);
+                v = (float)((double)ax * (double)cy - (double)ay * (double)cx);
+                w = (float)((double)bx * (double)ay - (double)by * (double)ax);
+            }
+
+            if ((u < 0.0f || v < 0.0f || w < 0.0f) && (u > 0.0f || v > 0.0f || w > 0.0f))
+                return std::numeric_limits<float>::infinity();
+
+            const float det = u + v + w;
+
+            if (det == 0.0f)
+                return std::numeric_limits<float>::infinity();
+
+            const float az = m_shear_z * a[m_kz];
+            const float bz = m_shear_z * b[m_kz];
+            const float cz = m_shear_z * c[m_kz];
+
+            const float t = (u * az + v * bz + w * cz) / det;
+
+            if (t <= t_min || t >= t_max)
+                return std::numeric_limits<float>::infinity();
+
+            return t;
+        }
+
+        float m_origin[3];
+        int m_kx = 0;
+        int m_ky = 1;
+        int m_kz = 2;
+        float m_shear_x = 0;
+        float m_shear_y = 0;
+        float m_shear_z = 1;
+    };
+
+    /**
+     * @brief Bounding volume hierarchy over the triangles of one mesh, in the object space of the mesh
+     *
+     * Built by the same BVHBuilder as the World BVH (binned SAH, flat node array, siblings next to each other), but
+     * over triangles given as an index buffer: building reorders the index triples so every leaf covers a contiguous
+     * range of triangles and the BVH itself stores nothing per triangle.
+     */
+    struct TriangleBVH
+    {
+        static constexpr uint32_t kMaxLeafSize = 4;
+        static constexpr int kStackSize = 64; // the build stops splitting below kStackSize - 1 levels, so traversal can't overflow it
+
+        // a triangle test is cheap next to a shape test, there is no transform and no virtual call
+        static constexpr float kTraversalCost = 1.0f;
+        static constexpr float kIntersectionCost = 1.0f;
+
+        [[nodiscard]] TriangleBVH() = default;
+
+        /**
+         * @brief Builds the hierarchy, reordering the triangles of `indices`
+         *
+         * @param positions The vertices of the mesh
+         * @param indices Three vertex indices per triangle
+         */
+        void build(const std::vector<Point> &positions, std::vector<uint32_t> &indices)
+        {
+            PROFILE_FUNCTION();
+
+            const uint32_t triangle_count = (uint32_t)(indices.size() / 3);
+
+            std::vector<AABB> bounds;
+            bounds.reserve(triangle_count);
+
+            for (uint32_t i = 0; i < triangle_count; i++)
+            {
+                AABB box;
+                box.expand(positions[indices[3 * i]]).expand(positions[indices[3 * i + 1]]).expand(positions[indices[3 * i + 2]]);
+
+                bounds.emplace_back(box);
+            }
+
+            // the triangles are the index triples, they move as a whole
+            BVHBuilder builder(m_nodes, std::move(bounds), {kTraversalCost, kIntersectionCost, kMaxLeafSize, kStackSize - 1}, [&indices](const uint32_t i, const uint32_t j)
+                               { std::swap_ranges(indices.begin() + 3 * i, indices.begin() + 3 * i + 3, indices.begin() + 3 * j); });
+            builder.build();
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_nodes.empty();
+        }
+
+        // bounds of the whole mesh
+        [[nodiscard]] AABB get_bounds() const noexcept
+        {
+            return m_nodes.empty() ? AABB() : m_nodes[0].m_bounds;
+        }
+
+        [[nodiscard]] const std::vector<BVHNode> &get_nodes() const noexcept
+        {
+            return m_nodes;
+        }
+
+        /**
+         * @brief Nearest triangle hit inside (t_min, t), nodes are visited front to back
+         *
+         * @param ray The ray in the object space of the mesh
+         * @param positions The vertices the BVH was built over
+         * @param indices The index buffer as reordered by build
+         * @param t_min Lower bound of the interval
+         * @param t In: upper bound of the interval. Out: distance to the hit if one was found
+         * @param triangle Out: the triangle that was hit
+         * @return true if a triangle was hit
+         */
+        [[nodiscard]] bool closest_hit(const Ray &ray, const std::vector<Point> &positions, const std::vector<uint32_t> &indices, const float t_min, float &t, uint32_t &triangle) const
+        {
+            if (m_nodes.empty())
+                return false;
+
+            const Vector inv_dir = inverse_direction(ray.m_direction);
+
+            if (m_nodes[0].m_bounds.intersects(ray.m_origin, inv_dir, t) == std::numeric_limits<float>::infinity())
+                return false;
+
+            const WatertightRay watertight_ray(ray);
+
+            bool found = false;
+
+            uint32_t stack[kStackSize];
+            float stack_t[kStackSize];
+            int stack_ptr = 0;
+
+            stack[stack_ptr] = 0;
+            stack_t[stack_ptr++] = 0;
+
+            while (stack_ptr > 0)
+            {
+                --stack_ptr;
+
+                if (stack_t[stack_ptr] > t)
+                    continue;
+
+                const BVHNode &node = m_nodes[stack[stack_ptr]];
+
+                if (node.is_leaf())
+                {
+                    for (uint32_t i = node.m_left_first; i < node.m_left_first + node.m_count; i++)
+                    {
+                        const float hit_t = watertight_ray.intersect(positions[indices[3 * i]], positions[indices[3 * i + 1]], positions[indices[3 * i + 2]], t_min, t);
+
+                        if (hit_t < t)
+                        {
+                            t = hit_t;
+                            triangle = i;
+                            found = true;
+                        }
+                    }
+
+                    continue;
+                }
+
+                uint32_t near_child = node.m_left_first;
+                uint32_t far_child = node.m_left_first + 1;
+
+                float near_t = m_nodes[near_child].m_bounds.intersects(ray.m_origin, inv_dir, t);
+                float far_t = m_nodes[far_child].m_bounds.intersects(ray.m_origin, inv_dir, t);
+
+                if (far_t < near_t)
+                {
+                    std::swap(near_child, far_child);
+                    std::swap(near_t, far_t);
+                }
+
+                if (far_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr] = far_child;
+                    stack_t[stack_ptr++] = far_t;
+                }
+
+                if (near_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr] = near_child;
+                    stack_t[stack_ptr++] = near_t;
+                }
+            }
+
+            return found;
+        }
+
+        // true if any triangle is hit inside (t_min, t_max), stops at the first one, children are visited near first
+        [[nodiscard]] bool occluded(const Ray &ray, const std::vector<Point> &positions, const std::vector<uint32_t> &indices, const float t_min, const float t_max) const
+        {
+            if (m_nodes.empty())
+                return false;
+
+            const Vector inv_dir = inverse_direction(ray.m_direction);
+
+            if (m_nodes[0].m_bounds.intersects(ray.m_origin, inv_dir, t_max) == std::numeric_limits<float>::infinity())
+                return false;
+
+            const WatertightRay watertight_ray(ray);
+
+            uint32_t stack[kStackSize];
+            int stack_ptr = 0;
+
+            stack[stack_ptr++] = 0;
+
+            while (stack_ptr > 0)
+            {
+                const BVHNode &node = m_nodes[stack[--stack_ptr]];
+
+                if (node.is_leaf())
+                {
+                    for (uint32_t i = node.m_left_first; i < node.m_left_first + node.m_count; i++)
+                        if (watertight_ray.intersect(positions[indices[3 * i]], positions[indices[3 * i + 1]], positions[indices[3 * i + 2]], t_min, t_max) < t_max)
+                            return true;
+
+                    continue;
+                }
+
+                uint32_t near_child = node.m_left_first;
+                uint32_t far_child = node.m_left_first + 1;
+
+                float near_t = m_nodes[near_child].m_bounds.intersects(ray.m_origin, inv_dir, t_max);
+                float far_t = m_nodes[far_child].m_bounds.intersects(ray.m_origin, inv_dir, t_max);
+
+                if (far_t < near_t)
+                {
+                    std::swap(near_child, far_child);
+                    std::swap(near_t, far_t);
+                }
+
+                if (far_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = far_child;
+                }
+
+                if (near_t != std::numeric_limits<float>::infinity())
+                {
+                    assert(stack_ptr < kStackSize);
+                    stack[stack_ptr++] = near_child;
+                }
+            }
+
+            return false;
+        }
+
+    private:
+        std::vector<BVHNode> m_nodes;
+    };
+} // namespace Karbon
@@ -2,6 +2,10 @@
 
 #include "Constants.hpp"
 #include "Matrix.hpp"
+#include "Rendering/ThreadPool.hpp"
+#include "Rendering/Tile.hpp"
+#include "Rendering/Wavefront.hpp"
+#include "Sampling/Sampler.hpp"
 #include "Tuples/Color.hpp"
 #include "Tuples/Point.hpp"
 #include "Tuples/Vector.hpp"
@@ -89,20 +93,17 @@ namespace Karbon
 
                     if (w.get_antialiasing_samples() == 1)
                     {
-                        Ray r = ray_for_pixel((float)x, (float)y);
+                        Sampler sampler = make_sampler(w, x, y, 0, 1);
 
-                        c += w.color_at(r);
+                        c += w.color_at(sample_ray(x, y, false, sampler), sampler);
                     }
                     else
                     {
                         for (int i = 0; i < w.get_antialiasing_samples(); i++)
                         {
-                            float u = (x + random<float>(-1, 1));
-                            float v = (y + random<float>(-1, 1));
+                            Sampler sampler = make_sampler(w, x, y, i, w.get_antialiasing_samples());
 
-                            Ray r = ray_for_pixel(u, v);
-
-                            c += w.color_at(r);
+                            c += w.color_at(sample_ray(x, y, true, sampler), sampler);
                         }
 
                         c *= (1.0f / w.get_antialiasing_samples());
@@ -137,20 +138,17 @@ namespace Karbon
 
                     if (w.get_antialiasing_samples() == 1)
                     {
-                        Ray r = ray_for_pixel((float)x, (float)y);
+                        Sampler sampler = make_sampler(w, x, y, 0, 1);
 
-                        c += w.color_at(r);
+                        c += w.color_at(sample_ray(x, y, false, sampler), sampler);
                     }
                     else
                     {
                         for (int i = 0; i < w.get_antialiasing_samples(); i++)
                         {
-                            float u = (x + random<float>(-1, 1));
-                            float v = (y + random<float>(-1, 1));
-
-                            Ray r = ray_for_pixel(u, v);
+                            Sampler sampler = make_sampler(w, x, y, i, w.get_antialiasing_samples());
 
-                            c += w.color_at(r);
+                            c += w.color_at(sample_ray(x, y, true, sampler), sampler);
                         }
 
                         c *= (1.0f / w.get_antialiasing_samples());
@@ -171,6 +169,190 @@ namespace Karbon
             return image;
         }
 
+        /**
+         * @brief Computes the final (gamma corrected, 0-255) color of a pixel, averaging the world's antialiasing samples
+         *
+         * With adaptive sampling the pixel stops early once its estimated error is below the world's threshold.
+         *
+         * @param w The world to render
+         * @param x Column of the pixel
+         * @param y Row of the pixel
+         * @param samples_taken Set to the number of samples averaged
+         * @return Color
+         */
+        [[nodiscard]] Color sample_pixel(const World &w, const int x, const int y, int &samples_taken) const
+        {
+            const int samples = w.get_antialiasing_samples();
+            const AdaptiveSampling &adaptive = w.get_adaptive_sampling();
+
+            PixelEstimate estimate;
+
+            for (int i = 0; i < samples && !adaptive.is_converged(estimate); i++)
+            {
+                Sampler sampler = make_sampler(w, x, y, i, samples);
+
+                estimate.add(w.color_at(sample_ray(x, y, samples != 1, sampler), sampler));
+            }
+
+            samples_taken = estimate.m_count;
+
+            return resolve_pixel(estimate.m_sum, estimate.m_count);
+        }
+
+        /**
+         * @brief sample_pixel for a RayPacket::kSide x RayPacket::kSide block of pixels
+         *
+         * Each sample's camera rays are traced as one packet, then every path continues on its own after its first hit.
+         * Pixels at or past (x_end, y_end) are left out of the packet, and so are the pixels that adaptive sampling
+         * found converged, the packet shrinks until every pixel is done.
+         *
+         * @param w The world to render
+         * @param x0 Column of the top left pixel
+         * @param y0 Row of the top left pixel
+         * @param x_end Column after the last pixel to shade
+         * @param y_end Row after the last pixel to shade
+         * @param image The image the pixels are written to
+         * @return uint64_t Samples traced for all pixels of the block together
+         */
+        uint64_t sample_block(const World &w, const int x0, const int y0, const int x_end, const int y_end, Color *image) const
+        {
+            const int samples = w.get_antialiasing_samples();
+            const AdaptiveSampling &adaptive = w.get_adaptive_sampling();
+            const uint32_t slots = block_slots(x0, y0, x_end, y_end);
+
+            PixelEstimate estimates[RayPacket::kSize];
+            Color colors[RayPacket::kSize];
+            RayPacket packet;
+            PacketHits hits;
+
+            uint32_t sampling = slots; // pixels that still take samples
+            uint64_t samples_taken = 0;
+
+            for (int sample = 0; sample < samples && sampling != 0; sample++)
+            {
+                trace_block(w, x0, y0, sampling, sample, samples, packet, hits, colors);
+
+                for (uint32_t rays = sampling; rays != 0; rays &= rays - 1)
+                {
+                    const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                    estimates[ray].add(colors[ray]);
+
+                    if (adaptive.is_converged(estimates[ray]))
+                        sampling &= ~(1u << ray);
+                }
+
+                samples_taken += (uint64_t)packet.count();
+            }
+
+            for (uint32_t rays = slots; rays != 0; rays &= rays - 1)
+            {
+                const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                const int x = x0 + (int)(ray % RayPacket::kSide);
+                const int y = y0 + (int)(ray / RayPacket::kSide);
+
+                image[y * m_width + x] = resolve_pixel(estimates[ray].m_sum, estimates[ray].m_count);
+            }
+
+            return samples_taken;
+        }
+
+        /**
+         * @brief Computes the final colors of the pixels of one tile, with 4x4 packets when packet tracing is on
+         *
+         * @param w The world to render
+         * @param tile The pixels to render
+         * @param image The image the pixels are written to, m_width * m_height entries
+         * @return uint64_t Samples traced for the tile
+         */
+        uint64_t render_tile(const World &w, const Tile &tile, Color *image) const
+        {
+            uint64_t samples_taken = 0;
+
+            if (m_packet_tracing)
+            {
+                for (int y = tile.m_y0; y < tile.m_y1; y += static_cast<int>(RayPacket::kSide))
+                    for (int x = tile.m_x0; x < tile.m_x1; x += static_cast<int>(RayPacket::kSide))
+                        samples_taken += sample_block(w, x, y, tile.m_x1, tile.m_y1, image);
+            }
+            else
+            {
+                for (int y = tile.m_y0; y < tile.m_y1; y++)
+                {
+                    for (int x = tile.m_x0; x < tile.m_x1; x++)
+                    {
+                        int pixel_samples = 0;
+                        image[y * m_width + x] = sample_pixel(w, x, y, pixel_samples);
+                        samples_taken += (uint64_t)pixel_samples;
+                    }
+                }
+            }
+
+            return samples_taken;
+        }
+
+        /**
+         * @brief Adds one jittered sample of every pixel in the tile to `accumulation`, a pass of progressive rendering
+         *
+         * @param w The world to render
+         * @param tile The pixels to sample
+         * @param sample Index of the sample (the pass), keys the random numbers of the paths
+         * @param accumulation Unresolved color sums of the whole image, m_width * m_height entries
+         */
+        void accumulate_tile(const World &w, const Tile &tile, const int sample, Color *accumulation) const
+        {
+            if (!m_packet_tracing)
+            {
+                for (int y = tile.m_y0; y < tile.m_y1; y++)
+                {
+                    for (int x = tile.m_x0; x < tile.m_x1; x++)
+                    {
+                        // the pass count isn't known up front, the samples are an open ended sequence
+                        Sampler sampler = make_sampler(w, x, y, sample, 0);
+
+                        accumulation[y * m_width + x] += w.color_at(sample_ray(x, y, true, sampler), sampler);
+                    }
+                }
+
+                return;
+            }
+
+            Color colors[RayPacket::kSize];
+            RayPacket packet;
+            PacketHits hits;
+
+            for (int y0 = tile.m_y0; y0 < tile.m_y1; y0 += static_cast<int>(RayPacket::kSide))
+            {
+                for (int x0 = tile.m_x0; x0 < tile.m_x1; x0 += static_cast<int>(RayPacket::kSide))
+                {
+                    trace_block(w, x0, y0, block_slots(x0, y0, tile.m_x1, tile.m_y1), sample, 0, packet, hits, colors);
+
+                    for (uint32_t rays = packet.m_active; rays != 0; rays &= rays - 1)
+                    {
+                        const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                        accumulation[(y0 + (int)(ray / RayPacket::kSide)) * m_width + x0 + (int)(ray % RayPacket::kSide)] += colors[ray];
+                    }
+                }
+            }
+        }
+
+        // averages the summed samples of a pixel and gamma corrects it, the result is 0-255
+        [[nodiscard]] static Color resolve_pixel(Color c, const int samples)
+        {
+            if (samples > 1)
+                c *= (1.0f / samples);
+
+            c = Color::scale(c, &map_to_range, 0, 255, 0, 1);
+
+            c = Color::gamma_correct(c);
+
+            c = Color::scale(c, &map_to_range, 0, 1, 0, 255);
+
+            return c;
+        }
+
         [[nodiscard]] std::shared_ptr<Color[]> render_multi_threaded(const World &w, const int thread_count = kCORE_COUNT)
         {
             PROFILE_FUNCTION();
@@ -185,6 +367,9 @@ namespace Karbon
 
             std::vector<std::thread> threads;
 
+            // every row is recorded like a tile
+            m_tile_stats.assign(static_cast<size_t>(m_height), TileStats());
+
             for (int i = 0; i < thread_count; i++)
             {
                 const int index = i;
@@ -195,58 +380,194 @@ namespace Karbon
                     {
                         debug_print("[RENDERER]: ","Thread {" + std::to_string(index + 1) + "}: Calculating Row: [" + std::to_string(y + 1) + '/' + std::to_string(m_height) + "]");
 
+                        Timer row_timer;
+                        uint64_t row_samples = 0;
+
                         for (int x = 0; x < m_width; x++)
                         {
-                            Color c;
+                            int samples_taken = 0;
+                            image.get()[y * m_width + x] = sample_pixel(w, x, y, samples_taken);
+                            row_samples += (uint64_t)samples_taken;
+                        }
 
-                            if (w.get_antialiasing_samples() == 1)
-                            {
-                                Ray r = ray_for_pixel((float)x, (float)y);
+                        m_tile_stats[static_cast<size_t>(y)] = {Tile{0, y, m_width, y + 1}, index, row_timer.elapsed_millis(), row_samples};
+                    } }));
+            }
 
-                                c += w.color_at(r);
+            for (auto &t : threads)
+                t.join();
 
-                                c = Color::scale(c, &map_to_range, 0, 255, 0, 1);
+            m_is_finished = true;
 
-                                c = Color::gamma_correct(c);
+            debug_print("[RENDERER]: ", "Multi-Threaded Rendering done in: " + std::to_string(timer.elapsed_millis()) + " ms");
 
-                                c = Color::scale(c, &map_to_range, 0, 1, 0, 255);
-                            } 
-                            else
-                            {
-                                for (int i = 0; i < w.get_antialiasing_samples(); i++)
-                                {
-                                    float u = (x + random<float>(-1,1));
-                                    float v = (y + random<float>(-1,1));
+            return image;
+        }
 
-                                    Ray r = ray_for_pixel(u, v);
+        /**
+         * @brief Renders the image tile by tile on the shared thread pool
+         *
+         * Tiles are handed out in Morton/Hilbert order and idle workers steal tiles from busy ones, so
+         * expensive regions (glass, deep bounces) don't stall a single thread. The time spent on every
+         * tile is recorded and can be read back with get_tile_stats(). With packet tracing on (the default)
+         * the camera rays of every 4x4 block are traced together, see sample_block.
+         *
+         * @param w The world to render
+         * @param thread_count Number of pool workers used
+         * @param tile_size Edge length of a tile in pixels
+         * @param order Order the tiles are queued in
+         * @return std::shared_ptr<Color[]>
+         */
+        [[nodiscard]] std::shared_ptr<Color[]> render_tiled(const World &w, const int thread_count = kCORE_COUNT, const int tile_size = 16, const TileOrder order = TileOrder::Morton)
+        {
+            PROFILE_FUNCTION();
 
-                                    c += w.color_at(r);
-                                }
+            m_is_finished = false;
 
-                                c *= (1.0f / w.get_antialiasing_samples());
+            debug_print("[RENDERER]: ", "Started Tiled Rendering");
 
-                                c = Color::scale(c, &map_to_range, 0, 255, 0, 1);
+            Timer timer;
 
-                                c = Color::gamma_correct(c);
+            std::shared_ptr<Color[]> image(new Color[m_width * m_height]);
 
-                                c = Color::scale(c, &map_to_range, 0, 1, 0, 255);
-                            }
-                            
-                            image.get() [y *m_width + x] = c;
-                        }
-                    } }));
-            }
+            const std::vector<Tile> tiles = make_tiles(m_width, m_height, tile_size, order);
 
-            for (auto &t : threads)
-                t.join();
+            m_tile_stats.assign(tiles.size(), TileStats());
+
+            ThreadPool::Get().run(
+                tiles.size(), [&](const size_t tile_index, const int worker_index)
+                {
+                    Timer tile_timer;
+
+                    const Tile &tile = tiles[tile_index];
+
+                    const uint64_t samples_taken = render_tile(w, tile, image.get());
+
+                    m_tile_stats[tile_index] = {tile, worker_index, tile_timer.elapsed_millis(), samples_taken}; },
+                thread_count);
 
             m_is_finished = true;
 
-            debug_print("[RENDERER]: ", "Multi-Threaded Rendering done in: " + std::to_string(timer.elapsed_millis()) + " ms");
+            debug_print("[RENDERER]: ", "Tiled Rendering done in: " + std::to_string(timer.elapsed_millis()) + " ms");
 
             return image;
         }
 
+        /**
+         * @brief Renders the image as a stream of waves, every tile is traced as one or more Wavefront batches
+         *
+         * Instead of following one path to its end before starting the next, up to Wavefront::kMaxPaths paths of a
+         * tile advance one bounce at a time in stages (generate, intersect, sort by material, shade/scatter, compact).
+         * Large tiles keep the material runs long, tiles are still spread over the thread pool like render_tiled.
+         * With packet tracing on the camera rays are intersected as 4x4 packets.
+         *
+         * @param w The world to render
+         * @param thread_count Number of pool workers used
+         * @param tile_size Edge length of a tile in pixels
+         * @param order Order the tiles are queued in
+         * @return std::shared_ptr<Color[]>
+         */
+        [[nodiscard]] std::shared_ptr<Color[]> render_wavefront(const World &w, const int thread_count = kCORE_COUNT, const int tile_size = 64, const TileOrder order = TileOrder::Morton)
+        {
+            PROFILE_FUNCTION();
+
+            m_is_finished = false;
+
+            debug_print("[RENDERER]: ", "Started Wavefront Rendering");
+
+            Timer timer;
+
+            std::shared_ptr<Color[]> image(new Color[m_width * m_height]);
+
+            const std::vector<Tile> tiles = make_tiles(m_width, m_height, tile_size, order);
+            const int samples = w.get_antialiasing_samples();
+
+            m_tile_stats.assign(tiles.size(), TileStats());
+
+            // one set of wave buffers per worker, reused for all of its tiles
+            std::vector<Wavefront> waves((size_t)std::max(thread_count, 1));
+
+            ThreadPool::Get().run(
+                tiles.size(), [&](const size_t tile_index, const int worker_index)
+                {
+                    Timer tile_timer;
+
+                    const Tile &tile = tiles[tile_index];
+                    Wavefront &wave = waves[(size_t)worker_index];
+
+                    wave.reset((size_t)tile.pixel_count());
+
+                    // as many samples per wave as fit, the camera rays are added block by block to form coherent packets
+                    const int wave_samples = std::clamp((int)(Wavefront::kMaxPaths / (size_t)tile.pixel_count()), 1, samples);
+
+                    for (int first_sample = 0; first_sample < samples; first_sample += wave_samples)
+                    {
+                        for (int sample = first_sample; sample < std::min(first_sample + wave_samples, samples); sample++)
+                            for (int by = tile.m_y0; by < tile.m_y1; by += static_cast<int>(RayPacket::kSide))
+                                for (int bx = tile.m_x0; bx < tile.m_x1; bx += static_cast<int>(RayPacket::kSide))
+                                    for (int y = by; y < std::min(by + (int)RayPacket::kSide, tile.m_y1); y++)
+                                        for (int x = bx; x < std::min(bx + (int)RayPacket::kSide, tile.m_x1); x++)
+                                        {
+                                            const uint32_t pixel = (uint32_t)((y - tile.m_y0) * tile.width() + (x - tile.m_x0));
+
+                                            Sampler sampler = make_sampler(w, x, y, sample, samples);
+                                            const Ray ray = sample_ray(x, y, samples != 1, sampler);
+
+                                            wave.add_path(ray, pixel, sampler);
+                                        }
+
+                        wave.trace(w, m_packet_tracing);
+                    }
+
+                    for (int y = tile.m_y0; y < tile.m_y1; y++)
+                        for (int x = tile.m_x0; x < tile.m_x1; x++)
+                            image.get()[y * m_width + x] = resolve_pixel(wave.get_radiance((uint32_t)((y - tile.m_y0) * tile.width() + (x - tile.m_x0))), samples);
+
+                    m_tile_stats[tile_index] = {tile, worker_index, tile_timer.elapsed_millis(), (uint64_t)tile.pixel_count() * (uint64_t)samples}; },
+                thread_count);
+
+            m_is_finished = true;
+
+            debug_print("[RENDERER]: ", "Wavefront Rendering done in: " + std::to_string(timer.elapsed_millis()) + " ms");
+
+            return image;
+        }
+
+        [[nodiscard]] constexpr bool get_packet_tracing() const
+        {
+            return m_packet_tracing;
+        }
+
+        // trace the camera rays of render_tiled and render_wavefront in 4x4 packets instead of one by one
+        void set_packet_tracing(const bool packet_tracing)
+        {
+            m_packet_tracing = packet_tracing;
+        }
+
+        // per-tile timings of the last render_multi_threaded (one per row), render_tiled or render_wavefront call
+        [[nodiscard]] const std::vector<TileStats> &get_tile_stats() const
+        {
+            return m_tile_stats;
+        }
+
+        // total busy time per worker of the last render_multi_threaded, render_tiled or render_wavefront call, in milliseconds
+        [[nodiscard]] std::vector<float> get_worker_times() const
+        {
+            std::vector<float> times;
+
+            for (const auto &stats : m_tile_stats)
+            {
+                const size_t worker = static_cast<size_t>(stats.m_worker);
+
+                if (worker >= times.size())
+                    times.resize(worker + 1, 0.0f);
+
+                times[worker] += stats.m_millis;
+            }
+
+            return times;
+        }
+
         // generate getters
         [[nodiscard]] constexpr int is_finished() const
         {
@@ -370,7 +691,7 @@ namespace Karbon
             m_rotation_y = rotation[1];
             m_rotation_z = rotation[2];
 
-            m_transform = Karbon::IDENTITY.translate(translation[0], translation[1], translation[2]).rotate(m_rotation_x, m_rotation_y, m_rotation_z);
+            m_transform = Matrix4::compose(m_translation, Vector(m_rotation_x, m_rotation_y, m_rotation_z), Vector(1, 1, 1));
             m_inverse_transform = m_transform.inverse();
 
             return *this;
@@ -383,7 +704,7 @@ namespace Karbon
             m_rotation_y = rotation[1] * (float)std::numbers::pi / 180.0f;
             m_rotation_z = rotation[2] * (float)std::numbers::pi / 180.0f;
 
-            m_transform = Karbon::IDENTITY.translate(translation[0], translation[1], translation[2]).rotate(m_rotation_x, m_rotation_y, m_rotation_z);
+            m_transform = Matrix4::compose(m_translation, Vector(m_rotation_x, m_rotation_y, m_rotation_z), Vector(1, 1, 1));
             m_inverse_transform = m_transform.inverse();
 
             return *this;
@@ -418,6 +739,63 @@ namespace Karbon
         }
 
     private:
+        // packet slots of the block at (x0, y0) that lie before (x_end, y_end)
+        [[nodiscard]] static uint32_t block_slots(const int x0, const int y0, const int x_end, const int y_end) noexcept
+        {
+            uint32_t slots = 0;
+
+            for (uint32_t i = 0; i < RayPacket::kSize; i++)
+                if (x0 + (int)(i % RayPacket::kSide) < x_end && y0 + (int)(i / RayPacket::kSide) < y_end)
+                    slots |= 1u << i;
+
+            return slots;
+        }
+
+        // traces sample `sample` of `samples` (0 if open ended) of the block pixels in `slots` as a packet, colors[i] gets the color seen by packet slot i
+        void trace_block(const World &w, const int x0, const int y0, const uint32_t slots, const int sample, const int samples, RayPacket &packet, PacketHits &hits, Color (&colors)[RayPacket::kSize]) const
+        {
+            Sampler samplers[RayPacket::kSize];
+
+            packet.clear();
+
+            for (uint32_t rays = slots; rays != 0; rays &= rays - 1)
+            {
+                const uint32_t i = (uint32_t)std::countr_zero(rays);
+                const int x = x0 + (int)(i % RayPacket::kSide);
+                const int y = y0 + (int)(i / RayPacket::kSide);
+
+                samplers[i] = make_sampler(w, x, y, sample, samples);
+                packet.set(i, sample_ray(x, y, samples != 1, samplers[i]));
+            }
+
+            w.closest_hit(packet, hits);
+
+            for (uint32_t rays = packet.m_active; rays != 0; rays &= rays - 1)
+            {
+                const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                colors[ray] = w.color_at(packet.m_rays[ray], hits[ray], samplers[ray]);
+            }
+        }
+
+        // the sample values of one camera sample, keyed by pixel and sample so it doesn't matter who traces it
+        [[nodiscard]] static Sampler make_sampler(const World &w, const int x, const int y, const int sample, const int samples) noexcept
+        {
+            return Sampler(w.get_sampler(), (uint32_t)x, (uint32_t)y, (uint32_t)sample, (uint32_t)samples);
+        }
+
+        // the camera ray of a sample, jittered by up to a pixel in each direction when antialiasing
+        [[nodiscard]] Ray sample_ray(const int x, const int y, const bool jitter, Sampler &sampler) const
+        {
+            if (!jitter)
+                return ray_for_pixel((float)x, (float)y);
+
+            float du, dv;
+            sampler.get_2d(du, dv);
+
+            return ray_for_pixel(x + 2.0f * du - 1.0f, y + 2.0f * dv - 1.0f);
+        }
+
         bool m_is_finished = false;
         int m_width;
         int m_height;
@@ -430,6 +808,9 @@ namespace Karbon
         Matrix4 m_transform = Karbon::IDENTITY;
         Matrix4 m_inverse_transform = Karbon::IDENTITY;
 
+        std::vector<TileStats> m_tile_stats;
+        bool m_packet_tracing = true;
+
         float m_half_width;
         float m_half_height;
     };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Sampling/Warp.hpp"
 #include "Shapes/Shape.hpp"
 #include "Tuples/Point.hpp"
 #include "Tuples/Vector.hpp"
@@ -56,12 +57,29 @@ namespace Karbon
         Point m_under_point;
     };
 
-    bool Lambertian::scatter(const Computation &comp, Color &attenuation, Ray &scattered) const
+    bool Lambertian::scatter(const Computation &comp, Color &attenuation, Ray &scattered, Sampler &sampler) const
     {
-        scattered = Ray::random_in_unit_sphere_with_direction(comp.m_over_point, comp.m_normal_vector);
+        float u, v;
+        sampler.get_2d(u, v);
+
+        // importance sampled by the cosine term, so the Lambertian weight is just the albedo
+        scattered = Ray(comp.m_over_point, cosine_hemisphere(u, v, comp.m_normal_vector));
         // attenuation = comp.m_s->get_pattern()->color_at(comp.m_p);
         attenuation = get_color();
         return true;
     }
 
+    Color Lambertian::evaluate(const Computation &comp, const Vector &direction) const
+    {
+        const float cos_theta = comp.m_normal_vector.dot(direction);
+
+        if (cos_theta <= 0)
+            return Karbon::BLACK;
+
+        Color f = get_color();
+        f *= cos_theta * (float)std::numbers::inv_pi;
+
+        return f;
+    }
+
 } // namespace Karbon
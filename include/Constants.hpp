@@ -3,10 +3,17 @@
 #include <algorithm>
 #include <array>
 #include <assert.h>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <charconv>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <deque>
 #include <filesystem>
 #include <fstream>
+#include <functional>
 #include <future>
 #include <iostream>
 #include <limits>
@@ -23,15 +30,20 @@
 #include <stack>
 #include <string>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <variant>
 #include <vector>
 
-// Set value to 1 to use the Profiling system
+// Set value to 1 (or pass -DPROFILING=1) to use the Profiling system
+#ifndef PROFILING
 #define PROFILING 0
+#endif
 
 #include "Profiling/Instrumentor.hpp"
+#include "Profiling/RayCounter.hpp"
 #include "Profiling/Timer.hpp"
 
 // define DEBUG macros here
@@ -77,8 +89,72 @@ inline T random(T min = 0.0, T max = 1.0)
 {
     thread_local std::random_device rd;
     thread_local std::mt19937 gen(rd());
-    thread_local std::uniform_real_distribution<> dis(min, max);
-    return (T)dis(gen); 
+
+    // a fresh distribution per call, a shared one would keep the bounds of the first call
+    std::uniform_real_distribution<> dis(min, max);
+    return (T)dis(gen);
+}
+
+/**
+ * @brief sin that can also run at compile time
+ *
+ * Constant evaluation uses a Taylor series after wrapping the angle into [-pi, pi], at runtime it is std::sin.
+ *
+ * @param radians The angle
+ * @return constexpr float
+ */
+inline constexpr float constexpr_sin(const float radians)
+{
+    if (!std::is_constant_evaluated())
+        return std::sin(radians);
+
+    constexpr double two_pi = 2.0 * std::numbers::pi;
+
+    double x = radians;
+    double turns = x / two_pi;
+    turns = (double)(long long)(turns + (turns < 0 ? -0.5 : 0.5));
+    x -= turns * two_pi;
+
+    double term = x;
+    double sum = x;
+
+    for (int i = 1; i < 12; i++)
+    {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+
+    return (float)sum;
+}
+
+/**
+ * @brief cos that can also run at compile time
+ *
+ * @param radians The angle
+ * @return constexpr float
+ */
+inline constexpr float constexpr_cos(const float radians)
+{
+    if (!std::is_constant_evaluated())
+        return std::cos(radians);
+
+    constexpr double two_pi = 2.0 * std::numbers::pi;
+
+    double x = radians;
+    double turns = x / two_pi;
+    turns = (double)(long long)(turns + (turns < 0 ? -0.5 : 0.5));
+    x -= turns * two_pi;
+
+    double term = 1;
+    double sum = 1;
+
+    for (int i = 1; i < 12; i++)
+    {
+        term *= -x * x / ((2 * i - 1) * (2 * i));
+        sum += term;
+    }
+
+    return (float)sum;
 }
 
 /**
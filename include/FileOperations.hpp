@@ -107,8 +107,21 @@ namespace Karbon
             pixels[index++] = (uint8_t)curr.b;
         }
 
-        // You have to use 3 comp for complete jpg file. If not, the image will be grayscale or nothing.
-        int result = stbi_write_jpg(filename.c_str(), width, height, 3, pixels, 100);
+        int result = 0;
+
+        std::string extension = get_file_extension(filename);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                       { return (char)std::tolower(c); });
+
+        if (extension == "png")
+            result = stbi_write_png(filename.c_str(), width, height, 3, pixels, width * 3);
+        else if (extension == "bmp")
+            result = stbi_write_bmp(filename.c_str(), width, height, 3, pixels);
+        else if (extension == "tga")
+            result = stbi_write_tga(filename.c_str(), width, height, 3, pixels);
+        else // You have to use 3 comp for complete jpg file. If not, the image will be grayscale or nothing.
+            result = stbi_write_jpg(filename.c_str(), width, height, 3, pixels, 100);
+
         delete[] pixels;
 
         if (result == 0)
@@ -14,12 +14,12 @@ namespace Karbon
 
         [[nodiscard]] constexpr Intersection() : m_t(-1), m_object(nullptr) {}
 
-        [[nodiscard]] constexpr Intersection(const float t, const Shape &object)
-            : m_t(t), m_object(&object)
+        [[nodiscard]] constexpr Intersection(const float t, const Shape &object, const uint32_t primitive = 0)
+            : m_t(t), m_object(&object), m_primitive(primitive)
         {
         }
 
-        [[nodiscard]] Computation prepare_computation(const Ray &ray, const std::vector<std::pair<float, Karbon::Shape *>> xs) const
+        [[nodiscard]] Computation prepare_computation(const Ray &ray, const std::vector<std::pair<float, Karbon::Shape *>> &xs = {}) const
         {
             PROFILE_FUNCTION();
 
@@ -27,7 +27,7 @@ namespace Karbon
             const Shape *object = m_object;
             Point p = ray.position(m_t);
             Vector eyev = -ray.m_direction;
-            Vector normalv = object->normal_at(p);
+            Vector normalv = object->normal_at_primitive(p, m_primitive);
             Vector reflectv = ray.m_direction.reflect(normalv);
 
             bool inside = false;
@@ -81,7 +81,7 @@ namespace Karbon
             return m_t == right.first && m_object == right.second;
         }
 
-        [[nodiscard]] static std::pair<float, Shape *> hit(std::vector<std::pair<float, Shape *>> intersections)
+        [[nodiscard]] static std::pair<float, Shape *> hit(const std::vector<std::pair<float, Shape *>> &intersections)
         {
             PROFILE_FUNCTION();
 
@@ -94,7 +94,7 @@ namespace Karbon
             return {};
         }
 
-        [[nodiscard]] static Intersection hit(std::vector<Intersection> intersections)
+        [[nodiscard]] static Intersection hit(const std::vector<Intersection> &intersections)
         {
             PROFILE_FUNCTION();
 
@@ -148,6 +148,7 @@ namespace Karbon
     public:
         float m_t;
         const Shape *m_object;
+        uint32_t m_primitive = 0; // see Hit::m_primitive
     };
 
 } // namespace Karbon
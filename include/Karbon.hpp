@@ -11,7 +11,13 @@
 #include "Tuples/Point.hpp"
 #include "Tuples/Vector.hpp"
 
+#include "Sampling/Adaptive.hpp"
+#include "Sampling/Rng.hpp"
+#include "Sampling/Sampler.hpp"
+#include "Sampling/Warp.hpp"
+
 #include "Lights/Light.hpp"
+#include "Lights/LightTree.hpp"
 #include "Lights/PointLight.hpp"
 
 #include "Computation.hpp"
@@ -22,16 +28,29 @@
 
 #include "Materials/Dielectric.hpp"
 #include "Materials/Lambertian.hpp"
+#include "Materials/MaterialTable.hpp"
 #include "Materials/Metal.hpp"
 
 #include "Shapes/Shape.hpp"
 
 #include "Shapes/Cube.hpp"
+#include "Shapes/Instance.hpp"
+#include "Shapes/MeshGeometry.hpp"
 #include "Shapes/Sphere.hpp"
+#include "Shapes/TriangleMesh.hpp"
 #include "Shapes/XYPlane.hpp"
 #include "Shapes/XZPlane.hpp"
 #include "Shapes/YZPlane.hpp"
 
+#include "ObjLoader.hpp"
+#include "Shapes/GeometryLibrary.hpp"
+
+#include "Acceleration/AABB.hpp"
+#include "Acceleration/Hit.hpp"
+#include "Acceleration/BVHBuilder.hpp"
+#include "Acceleration/BVH.hpp"
+#include "Acceleration/TriangleBVH.hpp"
+
 #include "Patterns/Pattern.hpp"
 
 #include "Patterns/Checker.hpp"
@@ -39,7 +58,13 @@
 #include "Patterns/Ring.hpp"
 #include "Patterns/Stripe.hpp"
 
+#include "Rendering/ThreadPool.hpp"
+#include "Rendering/Tile.hpp"
+
 #include "Camera.hpp"
 #include "World.hpp"
 
+#include "Rendering/ProgressiveRenderer.hpp"
+#include "Rendering/RenderQueue.hpp"
+
 #include "Scene.hpp"
\ No newline at end of file
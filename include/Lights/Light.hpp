@@ -18,6 +18,15 @@ namespace Karbon
         // getters
         [[nodiscard]] constexpr const Karbon::Color &get_intensity() const noexcept { return m_intensity; }
         [[nodiscard]] constexpr const Karbon::Point &get_position() const noexcept { return m_position; }
+        [[nodiscard]] constexpr float get_strength() const noexcept { return m_strength; }
+
+        // the light reaching a point `distance_squared` away, falling off with the square of the distance
+        [[nodiscard]] constexpr Karbon::Color radiance_at(const float distance_squared) const noexcept
+        {
+            Karbon::Color radiance = m_intensity;
+            radiance *= m_strength / distance_squared;
+            return radiance;
+        }
 
         // setters
         constexpr Light &set_intensity(const Karbon::Color &intensity) noexcept
@@ -31,6 +40,13 @@ namespace Karbon
             return *this;
         }
 
+        // scales the intensity, which is a color and so capped at 255 per channel
+        constexpr Light &set_strength(const float strength) noexcept
+        {
+            this->m_strength = strength;
+            return *this;
+        }
+
         // set m_intensity with a float[3]
         constexpr Light &set_intensity(const float (&intensity)[3]) noexcept
         {
@@ -59,5 +75,6 @@ namespace Karbon
 
         Karbon::Color m_intensity;
         Karbon::Point m_position;
+        float m_strength = 1.0f;
     };
 } // namespace Karbon
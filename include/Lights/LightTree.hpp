@@ -0,0 +1,248 @@
+#pragma once
+
+#include "Acceleration/AABB.hpp"
+#include "Constants.hpp"
+#include "Lights/Light.hpp"
+#include "Tuples/Color.hpp"
+#include "Tuples/Point.hpp"
+#include "Tuples/Vector.hpp"
+
+namespace Karbon
+{
+    // how World::direct_light picks the lights it sends shadow rays to
+    enum class LightSampling
+    {
+        All,     // every light, exact but linear in the light count
+        Uniform, // one light chosen uniformly
+        Tree,    // one light chosen through the LightTree, proportional to its estimated contribution
+        Count,
+    };
+
+    [[nodiscard]] constexpr const char *light_sampling_name(const LightSampling sampling) noexcept
+    {
+        switch (sampling)
+        {
+        case LightSampling::All:
+            return "All";
+        case LightSampling::Uniform:
+            return "Uniform";
+        case LightSampling::Tree:
+            return "Tree";
+        default:
+            return "Unknown";
+        }
+    }
+
+    // case-insensitive inverse of light_sampling_name, false if `name` is no light sampling strategy
+    [[nodiscard]] inline bool light_sampling_from_name(const std::string &name, LightSampling &sampling)
+    {
+        for (int i = 0; i < (int)LightSampling::Count; i++)
+        {
+            const std::string candidate = light_sampling_name((LightSampling)i);
+
+            if (std::equal(name.begin(), name.end(), candidate.begin(), candidate.end(), [](const char a, const char b)
+                           { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); }))
+            {
+                sampling = (LightSampling)i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    struct LightTreeNode
+    {
+        [[nodiscard]] constexpr bool is_leaf() const noexcept
+        {
+            return m_count > 0;
+        }
+
+        AABB m_bounds;
+        float m_power = 0;         // summed power of the lights below
+        uint32_t m_left_first = 0; // index of the left child for inner nodes (right child is m_left_first + 1), the light for leaves
+        uint32_t m_count = 0;      // 1 for leaves, 0 for inner nodes
+    };
+
+    /**
+     * @brief Binary tree over the point lights of a World for picking one of them in O(log n)
+     *
+     * Every node stores the bounds and total power of its lights. Sampling walks down from the root and at each node
+     * picks a child with probability proportional to its importance for the shading point: the power over the squared
+     * distance, times a bound on the cosine to the surface normal. The cosine bound is conservative, a child that could
+     * light the point is never given probability 0, so dividing by the pdf keeps the estimate unbiased.
+     *
+     * Point lights shine in every direction, so unlike the general light tree no emission cones are kept. Built by
+     * median splits along the longest axis, siblings are next to each other in a flat array like the BVH.
+     */
+    struct LightTree
+    {
+        [[nodiscard]] LightTree() = default;
+
+        void build(const std::vector<std::shared_ptr<Light>> &lights)
+        {
+            PROFILE_FUNCTION();
+
+            m_nodes.clear();
+            m_lights.clear();
+
+            if (lights.empty())
+                return;
+
+            m_lights.reserve(lights.size());
+
+            for (const auto &light : lights)
+                m_lights.emplace_back(light.get());
+
+            m_nodes.reserve(m_lights.size() * 2);
+            m_nodes.emplace_back();
+
+            subdivide(0, 0, (uint32_t)m_lights.size());
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_nodes.empty();
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return m_lights.size();
+        }
+
+        /**
+         * @brief Picks one light for a shading point
+         *
+         * @param point The shading point
+         * @param normal The surface normal at the point
+         * @param u Uniform number in [0, 1), reused down the tree
+         * @param pdf The probability the returned light was picked with
+         * @return const Light* nullptr if no light can reach the point
+         */
+        [[nodiscard]] const Light *sample(const Point &point, const Vector &normal, float u, float &pdf) const noexcept
+        {
+            if (m_nodes.empty())
+                return nullptr;
+
+            uint32_t index = 0;
+            pdf = 1;
+
+            while (!m_nodes[index].is_leaf())
+            {
+                const uint32_t left = m_nodes[index].m_left_first;
+
+                const float left_importance = importance(m_nodes[left], point, normal);
+                const float right_importance = importance(m_nodes[left + 1], point, normal);
+                const float total = left_importance + right_importance;
+
+                if (!(total > 0))
+                    return nullptr;
+
+                const float left_probability = left_importance / total;
+
+                // the part of u below the chosen probability is rescaled to [0, 1) for the next level
+                if (u < left_probability)
+                {
+                    u /= left_probability;
+                    pdf *= left_probability;
+                    index = left;
+                }
+                else
+                {
+                    u = (u - left_probability) / (1.0f - left_probability);
+                    pdf *= 1.0f - left_probability;
+                    index = left + 1;
+                }
+
+                u = std::min(u, 1.0f - std::numeric_limits<float>::epsilon());
+            }
+
+            return m_lights[m_nodes[index].m_left_first];
+        }
+
+    private:
+        // luminance of what the light sends out, in 0-255 units times the strength
+        [[nodiscard]] static float power(const Light &light) noexcept
+        {
+            const Color &c = light.get_intensity();
+            return (0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b) * light.get_strength();
+        }
+
+        // estimate of what the lights of `node` add at `point`, up to the unknown BRDF and visibility. Only 0 where
+        // no light of the node can reach the point, so sampling by it stays unbiased
+        [[nodiscard]] static float importance(const LightTreeNode &node, const Point &point, const Vector &normal) noexcept
+        {
+            const Vector to_center = node.m_bounds.centroid() - point;
+            const Vector extent = node.m_bounds.extent();
+
+            const float radius_squared = 0.25f * extent.dot(extent);
+            const float distance_squared = to_center.dot(to_center);
+
+            // inside the bounding sphere of the node the lights may be in any direction, the radius stands in for the distance
+            if (distance_squared <= radius_squared)
+                return node.m_power / std::max(radius_squared, (float)kEpsilon);
+
+            const float distance = std::sqrt(distance_squared);
+            const float cos_theta = normal.dot(to_center) / distance;
+
+            // the sphere covers the directions within theta_u of its center, the light closest to the normal bounds the cosine
+            const float sin_u = std::sqrt(radius_squared / distance_squared);
+            const float cos_u = std::sqrt(1.0f - sin_u * sin_u);
+
+            float cos_bound = 1;
+
+            if (cos_theta < cos_u)
+            {
+                const float sin_theta = std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
+                cos_bound = std::max(0.0f, cos_theta * cos_u + sin_theta * sin_u);
+            }
+
+            // the distance to the center, a bound on the falloff (the closest point of the sphere) hugely overrates
+            // nodes the point is just outside of and starves their siblings
+            return node.m_power * cos_bound / distance_squared;
+        }
+
+        // fills node `node_index` with the lights [first, last), splitting it until every leaf holds one
+        void subdivide(const uint32_t node_index, const uint32_t first, const uint32_t last)
+        {
+            AABB bounds;
+            float total_power = 0;
+
+            for (uint32_t i = first; i < last; i++)
+            {
+                bounds.expand(m_lights[i]->get_position());
+                total_power += power(*m_lights[i]);
+            }
+
+            m_nodes[node_index].m_bounds = bounds;
+            m_nodes[node_index].m_power = total_power;
+
+            if (last - first == 1)
+            {
+                m_nodes[node_index].m_left_first = first;
+                m_nodes[node_index].m_count = 1;
+                return;
+            }
+
+            const int axis = bounds.longest_axis();
+            const uint32_t middle = first + (last - first) / 2;
+
+            std::nth_element(m_lights.begin() + first, m_lights.begin() + middle, m_lights.begin() + last, [axis](const Light *a, const Light *b)
+                             { return a->get_position()[(char)axis] < b->get_position()[(char)axis]; });
+
+            const uint32_t left_child = (uint32_t)m_nodes.size();
+
+            m_nodes[node_index].m_left_first = left_child;
+            m_nodes[node_index].m_count = 0;
+
+            m_nodes.emplace_back();
+            m_nodes.emplace_back();
+
+            subdivide(left_child, first, middle);
+            subdivide(left_child + 1, middle, last);
+        }
+
+        std::vector<LightTreeNode> m_nodes;
+        std::vector<const Light *> m_lights; // reordered so every node covers a contiguous range
+    };
+} // namespace Karbon
@@ -17,7 +17,7 @@ namespace Karbon
         [[nodiscard]] bool operator==(const Light &rhs) const noexcept override
         {
             const auto other_point_light = dynamic_cast<const PointLight *>(&rhs);
-            return other_point_light != nullptr && other_point_light->get_position() == get_position() && other_point_light->get_intensity() == get_intensity();
+            return other_point_light != nullptr && other_point_light->get_position() == get_position() && other_point_light->get_intensity() == get_intensity() && other_point_light->get_strength() == get_strength();
         }
 
         // get name
@@ -33,6 +33,7 @@ namespace Karbon
             json["type"] = "PointLight";
             json["position"] = nlohmann::json::parse(get_position().to_json());
             json["intensity"] = nlohmann::json::parse(get_intensity().to_json());
+            json["strength"] = get_strength();
             return json.dump();
         }
 
@@ -46,6 +47,10 @@ namespace Karbon
             PointLight->set_position(Karbon::Point::from_json(json_object["position"].dump()));
             PointLight->set_intensity(Karbon::Color::from_json(json_object["intensity"].dump()));
 
+            // older scene files don't have it
+            if (json_object.contains("strength"))
+                PointLight->set_strength(json_object["strength"]);
+
             return PointLight;
         }
     };
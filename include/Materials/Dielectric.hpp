@@ -11,7 +11,7 @@
 namespace Karbon
 {
 
-    struct Dielectric : public Material
+    struct Dielectric final : public Material
     {
 
         [[nodiscard]] constexpr Dielectric(const Color &c = Color(1.0, 1.0, 1.0), const float refractive_index = 1.05f)
@@ -26,7 +26,7 @@ namespace Karbon
             set_refractive_index(other.get_refractive_index());
         }
 
-        bool scatter(const Computation &comp, Color &attenuation, Ray &scattered) const
+        bool scatter(const Computation &comp, Color &attenuation, Ray &scattered, Sampler &sampler) const
         {
             // attenuation = comp.m_s->get_pattern()->color_at(comp.m_p);
             attenuation = get_color();
@@ -39,7 +39,7 @@ namespace Karbon
 
             Vector direction;
 
-            if (sin2_t > 1.0 || comp.schilck() > random<float>())
+            if (sin2_t > 1.0 || comp.schilck() > sampler.get_1d())
                 direction = comp.m_reflection_vector;
             else
             {
@@ -53,6 +53,16 @@ namespace Karbon
             return true;
         }
 
+        [[nodiscard]] bool is_refractive() const override
+        {
+            return true;
+        }
+
+        [[nodiscard]] MaterialKind get_kind() const override
+        {
+            return MaterialKind::Dielectric;
+        }
+
         [[nodiscard]] virtual const char *get_name() const
         {
             return "Dielectric";
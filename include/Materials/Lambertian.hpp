@@ -11,7 +11,7 @@
 namespace Karbon
 {
 
-    struct Lambertian : public Material
+    struct Lambertian final : public Material
     {
 
         [[nodiscard]] constexpr Lambertian(const Color &c = Color(1.0, 1.0, 1.0))
@@ -24,7 +24,14 @@ namespace Karbon
             set_color(other.get_color());
         }
 
-        bool scatter(const Computation &comp, Color &attenuation, Ray &scattered) const;
+        bool scatter(const Computation &comp, Color &attenuation, Ray &scattered, Sampler &sampler) const;
+
+        [[nodiscard]] Color evaluate(const Computation &comp, const Vector &direction) const override;
+
+        [[nodiscard]] MaterialKind get_kind() const override
+        {
+            return MaterialKind::Diffuse;
+        }
 
         [[nodiscard]] virtual const char *get_name() const
         {
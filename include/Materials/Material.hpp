@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Ray.hpp"
+#include "Sampling/Sampler.hpp"
 #include "Tuples/Color.hpp"
 
 #include "Computation.hpp"
@@ -9,10 +10,27 @@ namespace Karbon
 {
     struct Computation;
 
+    // material classes the integrator can treat differently, e.g. a separate bounce limit per class
+    enum class MaterialKind
+    {
+        Diffuse,
+        Metal,
+        Dielectric,
+        Count
+    };
+
     struct Material
     {
 
-        virtual bool scatter(const Computation &comp, Color &attenuation, Ray &scattered) const = 0;
+        // sampler holds the sample values of the path being traced, scattering reads every random decision from the dimensions of its bounce
+        virtual bool scatter(const Computation &comp, Color &attenuation, Ray &scattered, Sampler &sampler) const = 0;
+
+        // BRDF times the cosine term for light arriving from `direction`, used to sample lights directly. Specular
+        // materials only reflect into single directions a light sample never hits exactly, they return black
+        [[nodiscard]] virtual Color evaluate([[maybe_unused]] const Computation &comp, [[maybe_unused]] const Vector &direction) const
+        {
+            return Karbon::BLACK;
+        }
 
         // get color
         [[nodiscard]] constexpr const Color &get_color() const noexcept
@@ -53,6 +71,14 @@ namespace Karbon
             return *this;
         }
 
+        // whether scattering needs n1/n2, which requires the full intersection list along the ray
+        [[nodiscard]] virtual bool is_refractive() const
+        {
+            return false;
+        }
+
+        [[nodiscard]] virtual MaterialKind get_kind() const = 0;
+
         [[nodiscard]] virtual const char *get_name() const = 0;
 
         // serialize all data to a nlohmann json string object
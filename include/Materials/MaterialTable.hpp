@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Computation.hpp"
+#include "Constants.hpp"
+#include "Materials/Dielectric.hpp"
+#include "Materials/Lambertian.hpp"
+#include "Materials/Material.hpp"
+#include "Materials/Metal.hpp"
+#include "Ray.hpp"
+#include "Tuples/Color.hpp"
+
+namespace Karbon
+{
+    // every material by value, the alternatives are in MaterialKind order
+    using MaterialVariant = std::variant<Lambertian, Metal, Dielectric>;
+
+    /**
+     * @brief The materials of a World stored by value in one contiguous array and referenced by index
+     *
+     * Shapes keep their shared_ptr<Material> as the editing interface, the table is a compiled snapshot of them (like
+     * the BVH) that the integrator uses: scatter is a switch over the variant index with no refcount and no virtual
+     * call, and the index of a hit material can be used to sort or batch paths by material.
+     */
+    struct MaterialTable
+    {
+        [[nodiscard]] MaterialTable() = default;
+
+        void clear()
+        {
+            m_materials.clear();
+            m_kinds.clear();
+            m_indices.clear();
+        }
+
+        [[nodiscard]] uint32_t size() const noexcept
+        {
+            return (uint32_t)m_materials.size();
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_materials.empty();
+        }
+
+        /**
+         * @brief Copies `material` into the table, a material shared by several shapes is stored once
+         *
+         * @param material A Lambertian, Metal or Dielectric
+         * @return uint32_t Index of the copy
+         */
+        uint32_t add(const Material &material)
+        {
+            const auto it = m_indices.find(&material);
+
+            if (it != m_indices.end())
+                return it->second;
+
+            const uint32_t index = size();
+
+            switch (material.get_kind())
+            {
+            case MaterialKind::Diffuse:
+                m_materials.emplace_back(std::in_place_type<Lambertian>, static_cast<const Lambertian &>(material));
+                break;
+            case MaterialKind::Metal:
+                m_materials.emplace_back(std::in_place_type<Metal>, static_cast<const Metal &>(material));
+                break;
+            case MaterialKind::Dielectric:
+                m_materials.emplace_back(std::in_place_type<Dielectric>, static_cast<const Dielectric &>(material));
+                break;
+            default:
+                assert(false && "unknown material kind");
+                m_materials.emplace_back(std::in_place_type<Lambertian>, material.get_color());
+                break;
+            }
+
+            m_kinds.emplace_back(material.get_kind());
+            m_indices.emplace(&material, index);
+
+            return index;
+        }
+
+        [[nodiscard]] const MaterialVariant &operator[](const uint32_t index) const noexcept
+        {
+            assert(index < size());
+            return m_materials[index];
+        }
+
+        // kept next to the variants so sorting by material class doesn't touch the material data
+        [[nodiscard]] MaterialKind get_kind(const uint32_t index) const noexcept
+        {
+            assert(index < size());
+            return m_kinds[index];
+        }
+
+        [[nodiscard]] bool is_refractive(const uint32_t index) const noexcept
+        {
+            return get_kind(index) == MaterialKind::Dielectric;
+        }
+
+        // the alternatives are final, so every branch of the visit calls its scatter directly
+        bool scatter(const uint32_t index, const Computation &comp, Color &attenuation, Ray &scattered, Sampler &sampler) const
+        {
+            assert(index < size());
+            return std::visit([&](const auto &material) { return material.scatter(comp, attenuation, scattered, sampler); }, m_materials[index]);
+        }
+
+        // true if evaluate is black for every direction, no point in sampling lights for it
+        [[nodiscard]] bool is_specular(const uint32_t index) const noexcept
+        {
+            return get_kind(index) != MaterialKind::Diffuse;
+        }
+
+        [[nodiscard]] Color evaluate(const uint32_t index, const Computation &comp, const Vector &direction) const
+        {
+            assert(index < size());
+            return std::visit([&](const auto &material) { return material.evaluate(comp, direction); }, m_materials[index]);
+        }
+
+    private:
+        std::vector<MaterialVariant> m_materials;
+        std::vector<MaterialKind> m_kinds; // indexed like m_materials
+
+        // the source material of each entry, only used while building
+        std::unordered_map<const Material *, uint32_t> m_indices;
+    };
+} // namespace Karbon
@@ -2,6 +2,7 @@
 
 #include "Materials/Material.hpp"
 #include "Ray.hpp"
+#include "Sampling/Warp.hpp"
 #include "Tuples/Color.hpp"
 
 #include "json.hpp"
@@ -11,7 +12,7 @@
 namespace Karbon
 {
 
-    struct Metal : public Material
+    struct Metal final : public Material
     {
 
         [[nodiscard]] constexpr Metal(const Color &c = Color(1.0, 1.0, 1.0), const float roughness = 0.0)
@@ -26,9 +27,12 @@ namespace Karbon
             m_roughness = other.m_roughness;
         }
 
-        bool scatter(const Computation &comp, Color &attenuation, Ray &scattered) const
+        bool scatter(const Computation &comp, Color &attenuation, Ray &scattered, Sampler &sampler) const
         {
-            scattered = Ray(comp.m_over_point, comp.m_reflection_vector + m_roughness * Vector::random_in_unit_sphere());
+            float u, v;
+            sampler.get_2d(u, v);
+
+            scattered = Ray(comp.m_over_point, comp.m_reflection_vector + m_roughness * uniform_sphere(u, v));
 
             // attenuation = comp.m_s->get_pattern()->color_at(comp.m_p);
             attenuation = get_color();
@@ -36,6 +40,11 @@ namespace Karbon
             return (scattered.m_direction.dot(comp.m_normal_vector) > 0);
         }
 
+        [[nodiscard]] MaterialKind get_kind() const override
+        {
+            return MaterialKind::Metal;
+        }
+
         [[nodiscard]] virtual const char *get_name() const
         {
             return "Metal";
@@ -48,6 +57,7 @@ namespace Karbon
             j["type"] = "Metal";
             j["refractive_index"] = get_refractive_index();
             j["color"] = nlohmann::json::parse(get_color().to_json());
+            j["roughness"] = m_roughness;
             return j.dump();
         }
 
@@ -61,6 +71,10 @@ namespace Karbon
             mat->set_color(Color::from_json(j["color"].dump()));
             mat->set_refractive_index(j["refractive_index"]);
 
+            // older scene files don't have it
+            if (j.contains("roughness"))
+                mat->set_roughness(j["roughness"]);
+
             return mat;
         }
 
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "Constants.hpp"
+#include "Simd.hpp"
 #include "Tuples/Point.hpp"
 #include "Tuples/Vector.hpp"
 #include "json.hpp"
 
 namespace Karbon
 {
+    struct AffineTransform;
+
     struct Matrix4
     {
 
@@ -113,17 +116,6 @@ namespace Karbon
             return result;
         }
 
-        // * by std::vector<std::vector<float>>
-        [[nodiscard]] constexpr Matrix4 operator*(const std::vector<std::vector<float>> &other) const noexcept
-        {
-            Matrix4 result;
-
-            for (char i = 0; i < 4; i++)
-                for (char j = 0; j < 4; j++)
-                    result._matrix[i][j] = this->_matrix[i][0] * other[0][j] + this->_matrix[i][1] * other[1][j] + this->_matrix[i][2] * other[2][j] + this->_matrix[i][3] * other[3][j];
-
-            return result;
-        }
         // * operator
         [[nodiscard]] constexpr Matrix4 operator*(const Matrix4 &other) const noexcept
         {
@@ -180,6 +172,55 @@ namespace Karbon
             return result;
         }
 
+        /**
+         * @brief Transforms a point and a direction at once, what every shape does to a ray before intersecting it
+         *
+         * Same result as `*this * origin` and `*this * direction`. The SSE path does the 6 row dot products as 6 vector
+         * multiplies and two transposed sums.
+         *
+         * @param origin The point to transform, w = 1
+         * @param direction The vector to transform, w = 0
+         * @param out_origin The transformed point
+         * @param out_direction The transformed vector
+         */
+        void transform(const Point &origin, const Vector &direction, Point &out_origin, Vector &out_direction) const noexcept
+        {
+#ifdef KARBON_SIMD_SSE
+            const __m128 row0 = _mm_loadu_ps(this->_matrix[0]);
+            const __m128 row1 = _mm_loadu_ps(this->_matrix[1]);
+            const __m128 row2 = _mm_loadu_ps(this->_matrix[2]);
+
+            const __m128 p = _mm_set_ps(1.0f, origin.z, origin.y, origin.x);
+            const __m128 d = _mm_set_ps(0.0f, direction.z, direction.y, direction.x);
+
+            // lanes: row0.p, row1.p, row2.p, row0.d
+            __m128 a0 = _mm_mul_ps(row0, p);
+            __m128 a1 = _mm_mul_ps(row1, p);
+            __m128 a2 = _mm_mul_ps(row2, p);
+            __m128 a3 = _mm_mul_ps(row0, d);
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+            const __m128 first = _mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3));
+
+            // lanes: row1.d, row2.d, 0, 0
+            __m128 b0 = _mm_mul_ps(row1, d);
+            __m128 b1 = _mm_mul_ps(row2, d);
+            __m128 b2 = _mm_setzero_ps();
+            __m128 b3 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+            const __m128 second = _mm_add_ps(_mm_add_ps(b0, b1), _mm_add_ps(b2, b3));
+
+            alignas(16) float result[8];
+            _mm_store_ps(result, first);
+            _mm_store_ps(result + 4, second);
+
+            out_origin = Point(result[0], result[1], result[2]);
+            out_direction = Vector(result[3], result[4], result[5]);
+#else
+            out_origin = *this * origin;
+            out_direction = *this * direction;
+#endif
+        }
+
         // *= operator
         [[nodiscard]] constexpr Matrix4 &operator*=(const Matrix4 &other) noexcept
         {
@@ -327,7 +368,7 @@ namespace Karbon
                     float temp_matrix[3][3];
                     sub_matrix<3>(_matrix, i, j, temp_matrix);
 
-                    cofactor[i][j] = (float)pow(-1, i + j) * determinant(temp_matrix);
+                    cofactor[i][j] = ((i + j) % 2 == 0 ? 1.0f : -1.0f) * determinant(temp_matrix);
                 }
             }
 
@@ -340,111 +381,130 @@ namespace Karbon
             return this->cofactor().transpose();
         }
 
-        // matrix inverse
-        [[nodiscard]] constexpr Matrix4 inverse() const noexcept
+        // whether the bottom row is (0, 0, 0, 1), i.e. the matrix is a 3x4 affine transform
+        [[nodiscard]] constexpr bool is_affine() const noexcept
+        {
+            return this->_matrix[3][0] == 0 && this->_matrix[3][1] == 0 && this->_matrix[3][2] == 0 && this->_matrix[3][3] == 1;
+        }
+
+        // matrix inverse, affine matrices take the closed form AffineTransform path
+        [[nodiscard]] constexpr Matrix4 inverse() const noexcept;
+
+        // general 4x4 inverse through the adjugate
+        [[nodiscard]] constexpr Matrix4 general_inverse() const noexcept
         {
             return this->adjugate() / this->determinant4();
         }
 
-        [[nodiscard]] Matrix4 translate(std::vector<float> const &values) const
+        // translation matrix
+        [[nodiscard]] static constexpr Matrix4 translation(const float x, const float y, const float z) noexcept
         {
-            std::vector<std::vector<float>> translation_values = {
-                {1, 0, 0, values[0]},
-                {0, 1, 0, values[1]},
-                {0, 0, 1, values[2]},
-                {0, 0, 0, 1},
-            };
+            return Matrix4(1, 0, 0, x,
+                           0, 1, 0, y,
+                           0, 0, 1, z,
+                           0, 0, 0, 1);
+        }
 
-            return *this * translation_values;
+        // scaling matrix
+        [[nodiscard]] static constexpr Matrix4 scaling(const float x, const float y, const float z) noexcept
+        {
+            return Matrix4(x, 0, 0, 0,
+                           0, y, 0, 0,
+                           0, 0, z, 0,
+                           0, 0, 0, 1);
         }
 
-        [[nodiscard]] Matrix4 translate(const float x, const float y, const float z) const
+        // rotation matrix around the x axis
+        [[nodiscard]] static constexpr Matrix4 rotation_x(const float radians) noexcept
         {
-            std::vector<std::vector<float>> translation_values = {
-                {1, 0, 0, x},
-                {0, 1, 0, y},
-                {0, 0, 1, z},
-                {0, 0, 0, 1},
-            };
+            const float c = constexpr_cos(radians);
+            const float s = constexpr_sin(radians);
 
-            return *this * translation_values;
+            return Matrix4(1, 0, 0, 0,
+                           0, c, -s, 0,
+                           0, s, c, 0,
+                           0, 0, 0, 1);
         }
 
-        [[nodiscard]] Matrix4 scale(std::vector<float> const &values) const
+        // rotation matrix around the y axis
+        [[nodiscard]] static constexpr Matrix4 rotation_y(const float radians) noexcept
         {
-            std::vector<std::vector<float>> translation_values = {
-                {values[0], 0, 0, 0},
-                {0, values[1], 0, 0},
-                {0, 0, values[2], 0},
-                {0, 0, 0, 1},
-            };
+            const float c = constexpr_cos(radians);
+            const float s = constexpr_sin(radians);
 
-            return *this * translation_values;
+            return Matrix4(c, 0, s, 0,
+                           0, 1, 0, 0,
+                           -s, 0, c, 0,
+                           0, 0, 0, 1);
         }
 
-        [[nodiscard]] Matrix4 scale(const float x, const float y, const float z) const
+        // rotation matrix around the z axis
+        [[nodiscard]] static constexpr Matrix4 rotation_z(const float radians) noexcept
         {
-            std::vector<std::vector<float>> translation_values = {
-                {x, 0, 0, 0},
-                {0, y, 0, 0},
-                {0, 0, z, 0},
-                {0, 0, 0, 1},
-            };
+            const float c = constexpr_cos(radians);
+            const float s = constexpr_sin(radians);
 
-            return *this * translation_values;
+            return Matrix4(c, -s, 0, 0,
+                           s, c, 0, 0,
+                           0, 0, 1, 0,
+                           0, 0, 0, 1);
         }
 
-        [[nodiscard]] Matrix4 rotate_x(const float radians) const
+        // shearing matrix
+        [[nodiscard]] static constexpr Matrix4 shearing(const float Xy, const float Xz, const float Yx, const float Yz, const float Zx, const float Zy) noexcept
         {
-            std::vector<std::vector<float>> rotate_x_values = {
-                {1, 0, 0, 0},
-                {0, std::cos(radians), -std::sin(radians), 0},
-                {0, std::sin(radians), std::cos(radians), 0},
-                {0, 0, 0, 1},
-            };
+            return Matrix4(1, Xy, Xz, 0,
+                           Yx, 1, Yz, 0,
+                           Zx, Zy, 1, 0,
+                           0, 0, 0, 1);
+        }
 
-            return *this * rotate_x_values;
+        // translation(t) * scaling(s) * rotation_x * rotation_y * rotation_z written out directly, see AffineTransform::compose
+        [[nodiscard]] static constexpr Matrix4 compose(const Vector &translation, const Vector &rotation, const Vector &scale) noexcept;
+
+        [[nodiscard]] constexpr Matrix4 translate(std::vector<float> const &values) const
+        {
+            return *this * Matrix4::translation(values[0], values[1], values[2]);
         }
 
-        [[nodiscard]] Matrix4 rotate_y(const float radians) const
+        [[nodiscard]] constexpr Matrix4 translate(const float x, const float y, const float z) const
         {
-            std::vector<std::vector<float>> rotate_y_values = {
-                {std::cos(radians), 0, std::sin(radians), 0},
-                {0, 1, 0, 0},
-                {-std::sin(radians), 0, std::cos(radians), 0},
-                {0, 0, 0, 1},
-            };
+            return *this * Matrix4::translation(x, y, z);
+        }
 
-            return *this * rotate_y_values;
+        [[nodiscard]] constexpr Matrix4 scale(std::vector<float> const &values) const
+        {
+            return *this * Matrix4::scaling(values[0], values[1], values[2]);
         }
 
-        [[nodiscard]] Matrix4 rotate_z(const float radians) const
+        [[nodiscard]] constexpr Matrix4 scale(const float x, const float y, const float z) const
         {
-            std::vector<std::vector<float>> rotate_z_values = {
-                {std::cos(radians), -std::sin(radians), 0, 0},
-                {std::sin(radians), std::cos(radians), 0, 0},
-                {0, 0, 1, 0},
-                {0, 0, 0, 1},
-            };
+            return *this * Matrix4::scaling(x, y, z);
+        }
 
-            return *this * rotate_z_values;
+        [[nodiscard]] constexpr Matrix4 rotate_x(const float radians) const
+        {
+            return *this * Matrix4::rotation_x(radians);
         }
 
-        [[nodiscard]] Matrix4 rotate(const float radians_x, const float radians_y, const float radians_z) const
+        [[nodiscard]] constexpr Matrix4 rotate_y(const float radians) const
         {
-            return this->rotate_x(radians_x).rotate_y(radians_y).rotate_z(radians_z);
+            return *this * Matrix4::rotation_y(radians);
         }
 
-        [[nodiscard]] Matrix4 shear(float Xy, float Xz, float Yx, float Yz, float Zx, float Zy) const
+        [[nodiscard]] constexpr Matrix4 rotate_z(const float radians) const
         {
-            std::vector<std::vector<float>> shear_values = {
-                {1, Xy, Xz, 0},
-                {Yx, 1, Yz, 0},
-                {Zx, Zy, 1, 0},
-                {0, 0, 0, 1},
-            };
+            return *this * Matrix4::rotation_z(radians);
+        }
 
-            return *this * shear_values;
+        [[nodiscard]] constexpr Matrix4 rotate(const float radians_x, const float radians_y, const float radians_z) const
+        {
+            return *this * Matrix4::compose(Vector(0, 0, 0), Vector(radians_x, radians_y, radians_z), Vector(1, 1, 1));
+        }
+
+        [[nodiscard]] constexpr Matrix4 shear(float Xy, float Xz, float Yx, float Yz, float Zx, float Zy) const
+        {
+            return *this * Matrix4::shearing(Xy, Xz, Yx, Yz, Zx, Zy);
         }
 
         // << operator
@@ -511,4 +571,193 @@ namespace Karbon
     };
 
     constexpr const Matrix4 IDENTITY = Matrix4();
+
+    /**
+     * @brief A 3x4 transform whose implied bottom row is (0, 0, 0, 1)
+     *
+     * Every shape and camera transform is a mix of translations, scales, rotations and shears, so it is always affine.
+     * Inverting one only needs the 3x3 linear part (9 cofactors) and the translation pushed through it, instead of the
+     * 16 3x3 determinants of Matrix4::general_inverse.
+     */
+    struct AffineTransform
+    {
+
+        [[nodiscard]] constexpr AffineTransform(){};
+
+        // takes the top 3 rows, the bottom row of the matrix is assumed to be (0, 0, 0, 1)
+        [[nodiscard]] explicit constexpr AffineTransform(const Matrix4 &matrix)
+        {
+            for (char i = 0; i < 3; i++)
+                for (char j = 0; j < 4; j++)
+                    this->_matrix[i][j] = matrix(i, j);
+        }
+
+        [[nodiscard]] constexpr AffineTransform(const float a00, const float a01, const float a02, const float a03, const float a10, const float a11, const float a12, const float a13, const float a20, const float a21, const float a22, const float a23)
+        {
+            this->_matrix[0][0] = a00;
+            this->_matrix[0][1] = a01;
+            this->_matrix[0][2] = a02;
+            this->_matrix[0][3] = a03;
+            this->_matrix[1][0] = a10;
+            this->_matrix[1][1] = a11;
+            this->_matrix[1][2] = a12;
+            this->_matrix[1][3] = a13;
+            this->_matrix[2][0] = a20;
+            this->_matrix[2][1] = a21;
+            this->_matrix[2][2] = a22;
+            this->_matrix[2][3] = a23;
+        }
+
+        [[nodiscard]] static constexpr AffineTransform translation(const float x, const float y, const float z) noexcept
+        {
+            return AffineTransform(1, 0, 0, x,
+                                   0, 1, 0, y,
+                                   0, 0, 1, z);
+        }
+
+        [[nodiscard]] static constexpr AffineTransform scaling(const float x, const float y, const float z) noexcept
+        {
+            return AffineTransform(x, 0, 0, 0,
+                                   0, y, 0, 0,
+                                   0, 0, z, 0);
+        }
+
+        [[nodiscard]] static constexpr AffineTransform rotation_x(const float radians) noexcept
+        {
+            const float c = constexpr_cos(radians);
+            const float s = constexpr_sin(radians);
+
+            return AffineTransform(1, 0, 0, 0,
+                                   0, c, -s, 0,
+                                   0, s, c, 0);
+        }
+
+        [[nodiscard]] static constexpr AffineTransform rotation_y(const float radians) noexcept
+        {
+            const float c = constexpr_cos(radians);
+            const float s = constexpr_sin(radians);
+
+            return AffineTransform(c, 0, s, 0,
+                                   0, 1, 0, 0,
+                                   -s, 0, c, 0);
+        }
+
+        [[nodiscard]] static constexpr AffineTransform rotation_z(const float radians) noexcept
+        {
+            const float c = constexpr_cos(radians);
+            const float s = constexpr_sin(radians);
+
+            return AffineTransform(c, -s, 0, 0,
+                                   s, c, 0, 0,
+                                   0, 0, 1, 0);
+        }
+
+        // translate * scale * rotate_x * rotate_y * rotate_z, the order Shape and Camera build their transforms in,
+        // with the three rotations multiplied out by hand so composing costs 6 trig calls and a few multiplies
+        [[nodiscard]] static constexpr AffineTransform compose(const Vector &translation, const Vector &rotation, const Vector &scale) noexcept
+        {
+            const float cx = constexpr_cos(rotation.x);
+            const float sx = constexpr_sin(rotation.x);
+            const float cy = constexpr_cos(rotation.y);
+            const float sy = constexpr_sin(rotation.y);
+            const float cz = constexpr_cos(rotation.z);
+            const float sz = constexpr_sin(rotation.z);
+
+            return AffineTransform(scale.x * (cy * cz), scale.x * (-cy * sz), scale.x * sy, translation.x,
+                                   scale.y * (sx * sy * cz + cx * sz), scale.y * (cx * cz - sx * sy * sz), scale.y * (-sx * cy), translation.y,
+                                   scale.z * (sx * sz - cx * sy * cz), scale.z * (cx * sy * sz + sx * cz), scale.z * (cx * cy), translation.z);
+        }
+
+        // () operator
+        [[nodiscard]] constexpr const float &operator()(const int row, const int column) const noexcept
+        {
+            return this->_matrix[row][column];
+        }
+
+        // * operator, the implied bottom rows make this 36 multiplies instead of 64
+        [[nodiscard]] constexpr AffineTransform operator*(const AffineTransform &other) const noexcept
+        {
+            AffineTransform result;
+
+            for (char i = 0; i < 3; i++)
+            {
+                for (char j = 0; j < 4; j++)
+                    result._matrix[i][j] = this->_matrix[i][0] * other._matrix[0][j] +
+                                           this->_matrix[i][1] * other._matrix[1][j] +
+                                           this->_matrix[i][2] * other._matrix[2][j];
+
+                result._matrix[i][3] += this->_matrix[i][3];
+            }
+
+            return result;
+        }
+
+        [[nodiscard]] constexpr Karbon::Vector operator*(const Karbon::Vector &other) const noexcept
+        {
+            return Karbon::Vector(this->_matrix[0][0] * other.x + this->_matrix[0][1] * other.y + this->_matrix[0][2] * other.z,
+                                  this->_matrix[1][0] * other.x + this->_matrix[1][1] * other.y + this->_matrix[1][2] * other.z,
+                                  this->_matrix[2][0] * other.x + this->_matrix[2][1] * other.y + this->_matrix[2][2] * other.z);
+        }
+
+        [[nodiscard]] constexpr Karbon::Point operator*(const Karbon::Point &other) const noexcept
+        {
+            return Karbon::Point(this->_matrix[0][0] * other.x + this->_matrix[0][1] * other.y + this->_matrix[0][2] * other.z + this->_matrix[0][3],
+                                 this->_matrix[1][0] * other.x + this->_matrix[1][1] * other.y + this->_matrix[1][2] * other.z + this->_matrix[1][3],
+                                 this->_matrix[2][0] * other.x + this->_matrix[2][1] * other.y + this->_matrix[2][2] * other.z + this->_matrix[2][3]);
+        }
+
+        // determinant of the linear 3x3 part, which is also the determinant of the whole 4x4 matrix
+        [[nodiscard]] constexpr float determinant() const noexcept
+        {
+            return this->_matrix[0][0] * (this->_matrix[1][1] * this->_matrix[2][2] - this->_matrix[1][2] * this->_matrix[2][1]) +
+                   this->_matrix[0][1] * (this->_matrix[1][2] * this->_matrix[2][0] - this->_matrix[1][0] * this->_matrix[2][2]) +
+                   this->_matrix[0][2] * (this->_matrix[1][0] * this->_matrix[2][1] - this->_matrix[1][1] * this->_matrix[2][0]);
+        }
+
+        // closed form inverse: invert the linear part, then move the translation through it
+        [[nodiscard]] constexpr AffineTransform inverse() const noexcept
+        {
+            const float(&m)[3][4] = this->_matrix;
+
+            const float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+            const float c10 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+            const float c20 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+            const float inv_det = 1.0f / (m[0][0] * c00 + m[0][1] * c10 + m[0][2] * c20);
+
+            AffineTransform result(
+                c00 * inv_det, (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det, (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det, 0,
+                c10 * inv_det, (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det, (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det, 0,
+                c20 * inv_det, (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det, (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det, 0);
+
+            for (char i = 0; i < 3; i++)
+                result._matrix[i][3] = -(result._matrix[i][0] * m[0][3] + result._matrix[i][1] * m[1][3] + result._matrix[i][2] * m[2][3]);
+
+            return result;
+        }
+
+        [[nodiscard]] constexpr Matrix4 to_matrix() const noexcept
+        {
+            return Matrix4(this->_matrix[0][0], this->_matrix[0][1], this->_matrix[0][2], this->_matrix[0][3],
+                           this->_matrix[1][0], this->_matrix[1][1], this->_matrix[1][2], this->_matrix[1][3],
+                           this->_matrix[2][0], this->_matrix[2][1], this->_matrix[2][2], this->_matrix[2][3],
+                           0, 0, 0, 1);
+        }
+
+    private:
+        float _matrix[3][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};
+    };
+
+    [[nodiscard]] constexpr Matrix4 Matrix4::compose(const Vector &translation, const Vector &rotation, const Vector &scale) noexcept
+    {
+        return AffineTransform::compose(translation, rotation, scale).to_matrix();
+    }
+
+    [[nodiscard]] constexpr Matrix4 Matrix4::inverse() const noexcept
+    {
+        if (is_affine())
+            return AffineTransform(*this).inverse().to_matrix();
+
+        return this->general_inverse();
+    }
 }; // namespace CLOAL
\ No newline at end of file
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "Shapes/MeshGeometry.hpp"
+#include "Tuples/Point.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief Streaming reader for the geometry of Wavefront OBJ files
+     *
+     * The file is read in fixed size blocks and parsed in place with std::from_chars, there is no per-line string or
+     * stream. Only `v` and `f` lines are used: faces in any of the v, v/vt, v//vn and v/vt/vn forms, with negative
+     * (relative) indices, polygons are fan triangulated. Texture coordinates, normals, groups and materials are
+     * skipped, meshes are shaded with their geometric normals.
+     */
+    struct ObjLoader
+    {
+        static constexpr size_t kBlockSize = 1 << 20;
+
+        /**
+         * @brief Loads the triangles of an OBJ file
+         *
+         * @param filepath Path of the .obj file
+         * @return std::shared_ptr<MeshGeometry> The mesh with its BVH built, nullptr if the file can't be read or is
+         * malformed
+         */
+        [[nodiscard]] static std::shared_ptr<MeshGeometry> load(const std::string &filepath)
+        {
+            PROFILE_FUNCTION();
+
+            debug_print("[IO]: ", std::string("Reading mesh: ") + filepath);
+
+            std::ifstream in(filepath, std::ios::in | std::ios::binary);
+
+            if (!in)
+            {
+                report("failed to open " + filepath);
+                return nullptr;
+            }
+
+            ObjLoader loader;
+            std::vector<char> buffer(kBlockSize);
+            size_t carried = 0; // bytes of an unfinished line kept at the front of the buffer
+
+            while (true)
+            {
+                // a line longer than the buffer, grow it
+                if (carried == buffer.size())
+                    buffer.resize(buffer.size() * 2);
+
+                in.read(buffer.data() + carried, (std::streamsize)(buffer.size() - carried));
+                const size_t size = carried + (size_t)in.gcount();
+                const bool end_of_file = in.gcount() == 0;
+
+                const char *begin = buffer.data();
+                const char *end = begin + size;
+
+                while (true)
+                {
+                    const char *newline = (const char *)std::memchr(begin, '\n', (size_t)(end - begin));
+
+                    // the last line of the file doesn't need a newline
+                    if (newline == nullptr && !end_of_file)
+                        break;
+
+                    const char *line_end = newline ? newline : end;
+
+                    if (!loader.parse_line(begin, line_end))
+                    {
+                        report("malformed OBJ line " + std::to_string(loader.m_line) + " in " + filepath);
+                        return nullptr;
+                    }
+
+                    if (newline == nullptr)
+                        break;
+
+                    begin = newline + 1;
+                }
+
+                if (end_of_file)
+                    break;
+
+                carried = (size_t)(end - begin);
+                std::memmove(buffer.data(), begin, carried);
+            }
+
+            for (const uint32_t index : loader.m_indices)
+            {
+                if (index >= loader.m_positions.size())
+                {
+                    report("OBJ face references a missing vertex in " + filepath);
+                    return nullptr;
+                }
+            }
+
+            if (loader.m_indices.empty())
+            {
+                report("OBJ file without faces " + filepath);
+                return nullptr;
+            }
+
+            return std::make_shared<MeshGeometry>(std::move(loader.m_positions), std::move(loader.m_indices));
+        }
+
+        // `file` as written in a scene file, relative paths are taken from base_directory (the scene's directory)
+        [[nodiscard]] static std::string resolve(const std::string &file, const std::string &base_directory)
+        {
+            std::filesystem::path path(file);
+
+            if (path.is_relative() && !base_directory.empty())
+                path = std::filesystem::path(base_directory) / path;
+
+            return path.lexically_normal().string();
+        }
+
+    private:
+        // a mesh that fails to load is left out of the scene, so this is printed in release builds too
+        static void report(const std::string &message)
+        {
+            std::cerr << "[IO]: " << message << std::endl;
+        }
+
+        [[nodiscard]] static const char *skip_spaces(const char *p, const char *end) noexcept
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+                p++;
+
+            return p;
+        }
+
+        [[nodiscard]] static bool parse_float(const char *&p, const char *end, float &value) noexcept
+        {
+            p = skip_spaces(p, end);
+
+            // from_chars doesn't take a leading plus
+            if (p < end && *p == '+')
+                p++;
+
+            const auto result = std::from_chars(p, end, value);
+            p = result.ptr;
+
+            return result.ec == std::errc();
+        }
+
+        // the position index of one face corner ("v", "v/vt", "v//vn" or "v/vt/vn"), made 0 based
+        [[nodiscard]] bool parse_corner(const char *&p, const char *end, uint32_t &index) const noexcept
+        {
+            int64_t value = 0;
+            const auto result = std::from_chars(p, end, value);
+
+            if (result.ec != std::errc() || value == 0)
+                return false;
+
+            p = result.ptr;
+
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+                p++;
+
+            // negative indices count back from the last vertex read so far
+            value = value < 0 ? (int64_t)m_positions.size() + value : value - 1;
+
+            if (value < 0 || value > (int64_t)std::numeric_limits<uint32_t>::max())
+                return false;
+
+            index = (uint32_t)value;
+
+            return true;
+        }
+
+        [[nodiscard]] bool parse_line(const char *p, const char *end)
+        {
+            m_line++;
+
+            if (const char *comment = (const char *)std::memchr(p, '#', (size_t)(end - p)))
+                end = comment;
+
+            p = skip_spaces(p, end);
+
+            if (p + 1 >= end || (p[1] != ' ' && p[1] != '\t'))
+                return true;
+
+            if (p[0] == 'v')
+            {
+                float x = 0;
+                float y = 0;
+                float z = 0;
+
+                p += 2;
+
+                if (!parse_float(p, end, x) || !parse_float(p, end, y) || !parse_float(p, end, z))
+                    return false;
+
+                m_positions.emplace_back(x, y, z);
+            }
+            else if (p[0] == 'f')
+            {
+                p += 2;
+
+                uint32_t first = 0;
+                uint32_t previous = 0;
+                int corners = 0;
+
+                for (p = skip_spaces(p, end); p < end; p = skip_spaces(p, end))
+                {
+                    uint32_t index = 0;
+
+                    if (!parse_corner(p, end, index))
+                        return false;
+
+                    // fan around the first corner
+                    if (corners == 0)
+                        first = index;
+                    else if (corners >= 2)
+                    {
+                        m_indices.emplace_back(first);
+                        m_indices.emplace_back(previous);
+                        m_indices.emplace_back(index);
+                    }
+
+                    previous = index;
+                    corners++;
+                }
+
+                if (corners < 3)
+                    return false;
+            }
+
+            return true;
+        }
+
+        std::vector<Point> m_positions;
+        std::vector<uint32_t> m_indices;
+        size_t m_line = 0;
+    };
+} // namespace Karbon
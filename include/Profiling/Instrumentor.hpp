@@ -32,24 +32,60 @@
 /**
  * @brief The result of a profiling session
  *
+ * Plain data so recording an event is a couple of stores, `name` has to outlive the session (string literals or intern())
  */
 struct ProfileResult
 {
-    const std::string name;
-    long long start, end;
+    const char *name;
+    long long start, end; // nanoseconds
     uint32_t threadID;
 };
 
 /**
  * @brief A simple timer class that can be used to measure the time it takes to execute a function or a block of code.
+ *
+ * Every thread records into its own buffer without locking, full buffers are handed to a writer thread that formats them
+ * while the session runs and whatever is left is written at endSession. endSession should be called once the profiled
+ * threads are idle, events still being recorded while it runs may be dropped.
  */
 class Instrumentor
 {
+    static constexpr uint32_t kChunkSize = 4096;
+
+    struct Chunk
+    {
+        std::array<ProfileResult, kChunkSize> events;
+        uint32_t count = 0;
+    };
+
+    struct ThreadBuffer
+    {
+        std::mutex lock; // only taken to swap chunks and to flush, never per event
+        std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>();
+        std::atomic<uint32_t> count = 0;
+        uint32_t session = 0;
+        uint32_t threadID = 0;
+    };
+
     std::string m_sessionName;
     std::ofstream m_outputStream;
     int m_profileCount = 0;
-    std::mutex m_lock;
-    bool m_activeSession = false;
+    std::atomic<bool> m_activeSession = false;
+    std::atomic<uint32_t> m_session = 0;
+
+    std::mutex m_buffersLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers; // kept alive after their thread exits so its events still get written
+
+    std::mutex m_queueLock;
+    std::condition_variable m_queueCondition;
+    std::vector<std::unique_ptr<Chunk>> m_fullChunks;
+    std::vector<std::unique_ptr<Chunk>> m_freeChunks; // written chunks are reused instead of reallocated
+    bool m_stopWriter = false;
+    std::thread m_writer;
+
+    std::mutex m_namesLock;
+    std::unordered_set<std::string> m_names;
+    std::unordered_map<const char *, std::string> m_escapedNames; // only used by the writer thread
 
     Instrumentor() {}
 
@@ -82,15 +118,21 @@ public:
         {
             endSession();
         }
-        m_activeSession = true;
         std::filesystem::create_directories(filepath);
         m_outputStream.open(filepath + "/perfetto_trace.json");
         writeHeader();
         m_sessionName = name;
+
+        m_stopWriter = false;
+        m_writer = std::thread([this]()
+                               { writerLoop(); });
+
+        m_session++;
+        m_activeSession = true;
     }
 
     /**
-     * @brief End the current profiling session
+     * @brief End the current profiling session, writes the events still sitting in the thread buffers
      *
      */
     void endSession()
@@ -100,37 +142,85 @@ public:
             return;
         }
         m_activeSession = false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_buffersLock);
+
+            for (auto &buffer : m_buffers)
+            {
+                std::lock_guard<std::mutex> buffer_lock(buffer->lock);
+
+                if (buffer->session != m_session)
+                    continue;
+
+                // copy the published events, the owning thread may still be writing past them
+                auto chunk = acquireChunk();
+                chunk->count = buffer->count.load(std::memory_order_acquire);
+                std::copy_n(buffer->chunk->events.begin(), chunk->count, chunk->events.begin());
+                submit(std::move(chunk));
+            }
+        }
+
+        m_session++; // buffers reset themselves on their next event
+
+        {
+            std::lock_guard<std::mutex> lock(m_queueLock);
+            m_stopWriter = true;
+        }
+        m_queueCondition.notify_one();
+        m_writer.join();
+
         writeFooter();
         m_outputStream.close();
         m_profileCount = 0;
     }
 
     /**
-     * @brief Write a profiling result to the output stream
+     * @brief Record a profiling result into the calling thread's buffer
      *
      * @param result
      */
-    void writeProfile(const ProfileResult &result)
+    void writeProfile(ProfileResult result)
     {
-        std::lock_guard<std::mutex> lock(m_lock);
+        if (!m_activeSession.load(std::memory_order_relaxed))
+            return;
 
-        if (m_profileCount++ > 0)
+        ThreadBuffer &buffer = localBuffer();
+        const uint32_t session = m_session.load(std::memory_order_relaxed);
+
+        if (buffer.session != session)
         {
-            m_outputStream << ",";
+            std::lock_guard<std::mutex> lock(buffer.lock);
+            buffer.session = session;
+            buffer.count.store(0, std::memory_order_relaxed);
         }
 
-        std::string name = result.name;
-        std::replace(name.begin(), name.end(), '"', '\'');
+        result.threadID = buffer.threadID;
+
+        const uint32_t index = buffer.count.load(std::memory_order_relaxed);
+        buffer.chunk->events[index] = result;
+        buffer.count.store(index + 1, std::memory_order_release);
 
-        m_outputStream << "{";
-        m_outputStream << "\"cat\":\"function\",";
-        m_outputStream << "\"dur\":" << (result.end - result.start) << ',';
-        m_outputStream << "\"name\":\"" << name << "\",";
-        m_outputStream << "\"ph\":\"X\",";
-        m_outputStream << "\"pid\":0,";
-        m_outputStream << "\"tid\":" << result.threadID << ",";
-        m_outputStream << "\"ts\":" << result.start;
-        m_outputStream << "}";
+        if (index + 1 == kChunkSize)
+        {
+            std::lock_guard<std::mutex> lock(buffer.lock);
+
+            buffer.chunk->count = kChunkSize;
+            submit(std::exchange(buffer.chunk, acquireChunk()));
+            buffer.count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Get a copy of `name` that lives as long as the Instrumentor, for scope names built at runtime
+     *
+     * @param name
+     * @return const char*
+     */
+    const char *intern(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(m_namesLock);
+        return m_names.emplace(name).first->c_str();
     }
 
     /**
@@ -150,29 +240,161 @@ public:
     {
         m_outputStream << "]}";
     }
+
+private:
+    ThreadBuffer &localBuffer()
+    {
+        // the raw pointer is constant initialized, so the hot path skips the thread_local init guard
+        thread_local ThreadBuffer *cached = nullptr;
+
+        if (cached)
+            return *cached;
+
+        thread_local std::shared_ptr<ThreadBuffer> buffer = [this]()
+        {
+            auto new_buffer = std::make_shared<ThreadBuffer>();
+            new_buffer->threadID = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+            std::lock_guard<std::mutex> lock(m_buffersLock);
+            m_buffers.emplace_back(new_buffer);
+
+            return new_buffer;
+        }();
+
+        cached = buffer.get();
+        return *cached;
+    }
+
+    std::unique_ptr<Chunk> acquireChunk()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_queueLock);
+
+            if (!m_freeChunks.empty())
+            {
+                auto chunk = std::move(m_freeChunks.back());
+                m_freeChunks.pop_back();
+                return chunk;
+            }
+        }
+
+        return std::make_unique<Chunk>();
+    }
+
+    void submit(std::unique_ptr<Chunk> chunk)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_queueLock);
+            m_fullChunks.emplace_back(std::move(chunk));
+        }
+        m_queueCondition.notify_one();
+    }
+
+    void writerLoop()
+    {
+        std::vector<std::unique_ptr<Chunk>> chunks;
+
+        while (true)
+        {
+            bool stop;
+
+            {
+                std::unique_lock<std::mutex> lock(m_queueLock);
+                m_queueCondition.wait(lock, [this]()
+                                      { return m_stopWriter || !m_fullChunks.empty(); });
+
+                std::swap(chunks, m_fullChunks);
+                stop = m_stopWriter;
+            }
+
+            for (auto &chunk : chunks)
+                writeChunk(*chunk);
+
+            {
+                std::lock_guard<std::mutex> lock(m_queueLock);
+
+                for (auto &chunk : chunks)
+                    m_freeChunks.emplace_back(std::move(chunk));
+            }
+            chunks.clear();
+
+            if (stop)
+                return;
+        }
+    }
+
+    void writeChunk(const Chunk &chunk)
+    {
+        char number[32];
+
+        auto write_micros = [&](const long long nanos)
+        {
+            // fixed point microseconds with nanosecond precision, avoids iostream float formatting
+            char *end = std::to_chars(number, number + sizeof(number), nanos / 1000).ptr;
+            *end++ = '.';
+            const long long fraction = nanos % 1000;
+            *end++ = (char)('0' + fraction / 100);
+            *end++ = (char)('0' + fraction / 10 % 10);
+            *end++ = (char)('0' + fraction % 10);
+            m_outputStream.write(number, end - number);
+        };
+
+        for (uint32_t i = 0; i < chunk.count; i++)
+        {
+            const ProfileResult &result = chunk.events[i];
+
+            if (m_profileCount++ > 0)
+            {
+                m_outputStream << ",";
+            }
+
+            m_outputStream << "{\"cat\":\"function\",\"dur\":";
+            write_micros(result.end - result.start);
+            m_outputStream << ",\"name\":\"" << escapedName(result.name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":";
+            m_outputStream.write(number, std::to_chars(number, number + sizeof(number), result.threadID).ptr - number);
+            m_outputStream << ",\"ts\":";
+            write_micros(result.start);
+            m_outputStream << "}";
+        }
+    }
+
+    // names are interned pointers, so they only have to be made json safe once
+    const std::string &escapedName(const char *name)
+    {
+        auto it = m_escapedNames.find(name);
+
+        if (it == m_escapedNames.end())
+        {
+            std::string escaped = name;
+            std::replace(escaped.begin(), escaped.end(), '"', '\'');
+            it = m_escapedNames.emplace(name, std::move(escaped)).first;
+        }
+
+        return it->second;
+    }
 };
 
 class InstrumentationTimer
 {
-    ProfileResult m_result;
+    const char *m_name;
 
     /**
      * @brief Variable to store the start time of the timer
      *
      */
-    std::chrono::time_point<std::chrono::high_resolution_clock> m_startTimepoint;
+    std::chrono::time_point<std::chrono::steady_clock> m_startTimepoint;
     bool m_stopped;
 
 public:
     /**
      * @brief Construct a new Instrumentation Timer object
      *
-     * @param name The name of the timer
+     * @param name The name of the timer, has to outlive the session (use Instrumentor::intern for runtime strings)
      */
-    InstrumentationTimer(const std::string &name)
-        : m_result({name, 0, 0, 0}), m_stopped(false)
+    InstrumentationTimer(const char *name)
+        : m_name(name), m_stopped(false)
     {
-        m_startTimepoint = std::chrono::high_resolution_clock::now();
+        m_startTimepoint = std::chrono::steady_clock::now();
     }
 
     ~InstrumentationTimer()
@@ -184,17 +406,17 @@ public:
     }
 
     /**
-     * @brief Stop the timer and write the result to the output stream
+     * @brief Stop the timer and record the result
      *
      */
     void stop()
     {
-        auto endTimepoint = std::chrono::high_resolution_clock::now();
+        auto endTimepoint = std::chrono::steady_clock::now();
 
-        m_result.start = std::chrono::time_point_cast<std::chrono::microseconds>(m_startTimepoint).time_since_epoch().count();
-        m_result.end = std::chrono::time_point_cast<std::chrono::microseconds>(endTimepoint).time_since_epoch().count();
-        m_result.threadID = static_cast<unsigned int>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
-        Instrumentor::Get().writeProfile(m_result);
+        Instrumentor::Get().writeProfile({m_name,
+                                          std::chrono::duration_cast<std::chrono::nanoseconds>(m_startTimepoint.time_since_epoch()).count(),
+                                          std::chrono::duration_cast<std::chrono::nanoseconds>(endTimepoint.time_since_epoch()).count(),
+                                          0});
 
         m_stopped = true;
     }
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Karbon
+{
+    /**
+     * @brief Counts traced rays across all threads without sharing a cache line between them
+     *
+     * Every thread gets its own counter (registered once, on first use) that only it writes to, so
+     * counting is a plain load/store. total() sums the counters of every thread that ever traced a
+     * ray, take the difference of two totals to measure a section.
+     */
+    struct RayCounter
+    {
+        static void add(const uint64_t count = 1) noexcept
+        {
+            std::atomic<uint64_t> &counter = local().m_count;
+            counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] static uint64_t total() noexcept
+        {
+            Registry &registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.m_lock);
+
+            uint64_t sum = 0;
+
+            for (const auto &slot : registry.m_slots)
+                sum += slot->m_count.load(std::memory_order_relaxed);
+
+            return sum;
+        }
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> m_count = 0;
+        };
+
+        struct Registry
+        {
+            std::mutex m_lock;
+            std::vector<std::shared_ptr<Slot>> m_slots; // kept alive after their thread exits so totals don't drop
+        };
+
+        [[nodiscard]] static Registry &get_registry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        [[nodiscard]] static Slot &local()
+        {
+            thread_local std::shared_ptr<Slot> slot = []()
+            {
+                auto new_slot = std::make_shared<Slot>();
+
+                Registry &registry = get_registry();
+                std::lock_guard<std::mutex> lock(registry.m_lock);
+                registry.m_slots.emplace_back(new_slot);
+
+                return new_slot;
+            }();
+
+            return *slot;
+        }
+    };
+} // namespace Karbon
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Matrix.hpp"
+#include "Sampling/Warp.hpp"
 #include "Tuples/Point.hpp"
 #include "Tuples/Vector.hpp"
 
@@ -22,16 +24,13 @@ namespace Karbon
             return Ray(p, Vector::random_in_unit_sphere());
         }
 
+        // a uniform direction in the hemisphere around the unit vector `direction`
         [[nodiscard]] static Ray random_in_unit_sphere_with_direction(const Point &p, const Vector &direction)
         {
-            Vector res = Vector::random_in_unit_sphere();
+            const float u = random<float>(0, 1);
+            const float v = random<float>(0, 1);
 
-            while (res.dot(direction) <= 0)
-            {
-                res = Vector::random_in_unit_sphere();
-            }
-
-            return Ray(p, res);
+            return Ray(p, uniform_hemisphere(u, v, direction));
         }
 
         [[nodiscard]] Point position(const float t) const
@@ -41,10 +40,11 @@ namespace Karbon
 
         [[nodiscard]] Ray transform(const Matrix4 &matrix) const
         {
-            Point new_origin = matrix * m_origin;
-            Vector new_direction = matrix * m_direction;
+            Ray result;
+
+            matrix.transform(m_origin, m_direction, result.m_origin, result.m_direction);
 
-            return Ray(new_origin, new_direction);
+            return result;
         }
 
         // << operator
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "Camera.hpp"
+#include "Constants.hpp"
+#include "Rendering/ThreadPool.hpp"
+#include "Rendering/Tile.hpp"
+#include "Tuples/Color.hpp"
+#include "World.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief Renders in the background one sample per pixel per pass, accumulating into a float buffer
+     *
+     * The first snapshot is ready after a single pass, later ones get less noisy. Snapshots are published at most every
+     * publish interval (and after the last pass) and picked up with take_snapshot, so a UI can show the image while it
+     * converges. The renderer works on its own copy of the camera and world; when the scene changes, call start again
+     * with the new scene, which cancels the running passes first.
+     */
+    struct ProgressiveRenderer
+    {
+        [[nodiscard]] ProgressiveRenderer() = default;
+
+        ProgressiveRenderer(const ProgressiveRenderer &) = delete;
+        ProgressiveRenderer &operator=(const ProgressiveRenderer &) = delete;
+
+        ~ProgressiveRenderer()
+        {
+            stop();
+        }
+
+        /**
+         * @brief Cancels the running render and starts accumulating the given scene
+         *
+         * @param camera The camera to render through, copied
+         * @param world The world to render, copied (the caller may edit it afterwards)
+         * @param max_samples Passes to run, 0 runs until stop() or the next start()
+         * @param thread_count Number of pool workers used per pass
+         */
+        void start(const Camera &camera, const World &world, const int max_samples = 0, const int thread_count = kCORE_COUNT)
+        {
+            PROFILE_FUNCTION();
+
+            stop();
+
+            m_camera = camera;
+            m_world.copy_from(world);
+            m_max_samples = max_samples;
+            m_thread_count = thread_count;
+
+            m_accumulation.assign((size_t)m_camera.get_width() * (size_t)m_camera.get_height(), Color());
+            m_tiles = make_tiles(m_camera.get_width(), m_camera.get_height(), 16, TileOrder::Morton);
+
+            {
+                std::lock_guard<std::mutex> lock(m_snapshot_lock);
+                m_snapshot = nullptr;
+                m_snapshot_samples = 0;
+                m_snapshot_fresh = false;
+            }
+
+            m_cancelled = false;
+            m_running = true;
+            m_thread = std::thread([this]()
+                                   { run(); });
+        }
+
+        // cancels the render and waits for the workers to leave the current pass
+        void stop()
+        {
+            m_cancelled = true;
+
+            if (m_thread.joinable())
+                m_thread.join();
+
+            m_running = false;
+        }
+
+        [[nodiscard]] bool is_running() const noexcept
+        {
+            return m_running;
+        }
+
+        /**
+         * @brief Takes the latest snapshot if it wasn't taken yet
+         *
+         * @param samples Set to the samples per pixel in the snapshot
+         * @return std::shared_ptr<Color[]> Gamma corrected 0-255 colors like Camera::render_tiled, nullptr if nothing new was published
+         */
+        [[nodiscard]] std::shared_ptr<Color[]> take_snapshot(int &samples)
+        {
+            std::lock_guard<std::mutex> lock(m_snapshot_lock);
+
+            if (!m_snapshot_fresh)
+                return nullptr;
+
+            m_snapshot_fresh = false;
+            samples = m_snapshot_samples;
+
+            return m_snapshot;
+        }
+
+        // samples per pixel of the latest published snapshot
+        [[nodiscard]] int get_sample_count() const
+        {
+            std::lock_guard<std::mutex> lock(m_snapshot_lock);
+            return m_snapshot_samples;
+        }
+
+        [[nodiscard]] float get_publish_interval() const noexcept
+        {
+            return m_publish_interval;
+        }
+
+        // minimum time between two snapshots in milliseconds, resolving the image isn't free
+        void set_publish_interval(const float millis) noexcept
+        {
+            m_publish_interval = millis;
+        }
+
+        [[nodiscard]] int get_first_sample() const noexcept
+        {
+            return m_first_sample;
+        }
+
+        // sample index of the first pass, renders that start far enough apart use independent sample values
+        void set_first_sample(const int first_sample) noexcept
+        {
+            m_first_sample = first_sample;
+        }
+
+    private:
+        void run()
+        {
+            Timer publish_timer;
+
+            for (int pass = 0; !m_cancelled && (m_max_samples == 0 || pass < m_max_samples); pass++)
+            {
+                ThreadPool::Get().run(
+                    m_tiles.size(), [&](const size_t tile_index, [[maybe_unused]] const int worker_index)
+                    {
+                        if (!m_cancelled)
+                            m_camera.accumulate_tile(m_world, m_tiles[tile_index], m_first_sample + pass, m_accumulation.data()); },
+                    m_thread_count);
+
+                // a cancelled pass is incomplete, publishing it would darken the skipped tiles
+                if (m_cancelled)
+                    break;
+
+                // the first pass is shown right away, that's the time to first image
+                if (pass == 0 || pass + 1 == m_max_samples || publish_timer.elapsed_millis() >= m_publish_interval)
+                {
+                    publish(pass + 1);
+                    publish_timer.reset();
+                }
+            }
+
+            m_running = false;
+        }
+
+        void publish(const int samples)
+        {
+            PROFILE_FUNCTION();
+
+            std::shared_ptr<Color[]> image(new Color[m_accumulation.size()]);
+
+            for (size_t i = 0; i < m_accumulation.size(); i++)
+                image.get()[i] = Camera::resolve_pixel(m_accumulation[i], samples);
+
+            std::lock_guard<std::mutex> lock(m_snapshot_lock);
+            m_snapshot = image;
+            m_snapshot_samples = samples;
+            m_snapshot_fresh = true;
+        }
+
+        // only touched by the render thread while it runs
+        Camera m_camera = Camera(1, 1, 1);
+        World m_world;
+        std::vector<Color> m_accumulation;
+        std::vector<Tile> m_tiles;
+        int m_max_samples = 0;
+        int m_thread_count = kCORE_COUNT;
+
+        std::thread m_thread;
+        std::atomic<bool> m_cancelled = false;
+        std::atomic<bool> m_running = false;
+        std::atomic<float> m_publish_interval = 100.0f;
+        std::atomic<int> m_first_sample = 0;
+
+        mutable std::mutex m_snapshot_lock; // guards everything below
+        std::shared_ptr<Color[]> m_snapshot;
+        int m_snapshot_samples = 0;
+        bool m_snapshot_fresh = false;
+    };
+} // namespace Karbon
@@ -0,0 +1,287 @@
+#pragma once
+
+#include "Camera.hpp"
+#include "Constants.hpp"
+#include "Rendering/ThreadPool.hpp"
+#include "Rendering/Tile.hpp"
+#include "Tuples/Color.hpp"
+#include "World.hpp"
+
+namespace Karbon
+{
+    enum class RenderJobStatus
+    {
+        Queued,
+        Running,
+        Finished,
+        Cancelled,
+    };
+
+    struct RenderJobOptions
+    {
+        int m_priority = 0; // higher runs first, a running job is preempted between chunks of tiles
+        int m_thread_count = kCORE_COUNT;
+        int m_tile_size = 16;
+        TileOrder m_order = TileOrder::Morton;
+    };
+
+    struct RenderProgress
+    {
+        [[nodiscard]] constexpr float fraction() const noexcept
+        {
+            return m_tile_count == 0 ? 1.0f : (float)m_tiles_done / (float)m_tile_count;
+        }
+
+        size_t m_tiles_done = 0;
+        size_t m_tile_count = 0;
+        uint64_t m_samples_done = 0; // camera samples traced
+    };
+
+    // state of one submitted render, shared by the RenderQueue and the handles
+    struct RenderJob
+    {
+        Camera m_camera = Camera(1, 1, 1);
+        World m_world;
+        RenderJobOptions m_options;
+        uint64_t m_sequence = 0; // submission order, breaks priority ties
+
+        std::vector<Tile> m_tiles;
+        std::shared_ptr<Color[]> m_image;
+        size_t m_next_tile = 0; // only touched by the dispatcher
+
+        std::atomic<size_t> m_tiles_done = 0;
+        std::atomic<uint64_t> m_samples_done = 0;
+        std::atomic<RenderJobStatus> m_status = RenderJobStatus::Queued;
+        std::atomic<bool> m_cancelled = false;
+
+        std::promise<std::shared_ptr<Color[]>> m_promise;
+        std::shared_future<std::shared_ptr<Color[]>> m_future = m_promise.get_future().share();
+    };
+
+    /**
+     * @brief The caller's side of a submitted render
+     *
+     * Handles are cheap to copy and stay valid after the job is done. The future yields the finished image
+     * (gamma corrected 0-255 colors like Camera::render_tiled), or nullptr if the job was cancelled.
+     */
+    struct RenderJobHandle
+    {
+        [[nodiscard]] RenderJobHandle() = default;
+        [[nodiscard]] explicit RenderJobHandle(std::shared_ptr<RenderJob> job) : m_job(std::move(job)) {}
+
+        [[nodiscard]] bool is_valid() const noexcept
+        {
+            return m_job != nullptr;
+        }
+
+        [[nodiscard]] RenderJobStatus get_status() const noexcept
+        {
+            return m_job->m_status;
+        }
+
+        [[nodiscard]] RenderProgress get_progress() const noexcept
+        {
+            return {m_job->m_tiles_done, m_job->m_tiles.size(), m_job->m_samples_done};
+        }
+
+        // stops the job after the tiles in flight, a queued job never starts; the future then yields nullptr
+        void cancel() noexcept
+        {
+            m_job->m_cancelled = true;
+        }
+
+        [[nodiscard]] const std::shared_future<std::shared_ptr<Color[]>> &get_future() const noexcept
+        {
+            return m_job->m_future;
+        }
+
+        // true if the job finished or was cancelled within `timeout`
+        template <typename Rep, typename Period>
+        [[nodiscard]] bool wait_for(const std::chrono::duration<Rep, Period> &timeout) const
+        {
+            return m_job->m_future.wait_for(timeout) == std::future_status::ready;
+        }
+
+        // blocks until the job is done, nullptr if it was cancelled
+        [[nodiscard]] std::shared_ptr<Color[]> get() const
+        {
+            return m_job->m_future.get();
+        }
+
+    private:
+        std::shared_ptr<RenderJob> m_job;
+    };
+
+    /**
+     * @brief Runs submitted renders in the background, highest priority first
+     *
+     * A dispatcher thread feeds the tiles of the chosen job to the shared ThreadPool a chunk at a time and picks the
+     * job again after every chunk, so a higher priority submission preempts a running render within a few tiles and
+     * the preempted one resumes where it stopped. Jobs work on their own copy of the camera and world.
+     */
+    struct RenderQueue
+    {
+        [[nodiscard]] RenderQueue()
+        {
+            m_dispatcher = std::thread([this]()
+                                       { dispatch(); });
+        }
+
+        RenderQueue(const RenderQueue &) = delete;
+        RenderQueue &operator=(const RenderQueue &) = delete;
+
+        // cancels every job that is still queued or running
+        ~RenderQueue()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+
+                for (auto &job : m_jobs)
+                    job->m_cancelled = true;
+
+                m_stopping = true;
+            }
+
+            m_job_added.notify_all();
+            m_dispatcher.join();
+        }
+
+        /**
+         * @brief Queues a render of the world through the camera
+         *
+         * @param camera The camera to render through, copied
+         * @param world The world to render, copied (the caller may edit it afterwards)
+         * @param options Priority and scheduling of the job
+         * @return RenderJobHandle
+         */
+        [[nodiscard]] RenderJobHandle submit(const Camera &camera, const World &world, const RenderJobOptions &options = RenderJobOptions())
+        {
+            PROFILE_FUNCTION();
+
+            auto job = std::make_shared<RenderJob>();
+
+            job->m_camera = camera;
+            job->m_world.copy_from(world);
+            job->m_options = options;
+            job->m_tiles = make_tiles(camera.get_width(), camera.get_height(), options.m_tile_size, options.m_order);
+            job->m_image = std::shared_ptr<Color[]>(new Color[(size_t)camera.get_width() * (size_t)camera.get_height()]);
+
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                job->m_sequence = m_sequence++;
+                m_jobs.emplace_back(job);
+            }
+
+            m_job_added.notify_one();
+
+            return RenderJobHandle(job);
+        }
+
+        // jobs queued or running
+        [[nodiscard]] size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            return m_jobs.size();
+        }
+
+    private:
+        // cancelled jobs first so their futures resolve right away, then by priority and submission order
+        [[nodiscard]] std::shared_ptr<RenderJob> pick_job() const
+        {
+            auto before = [](const std::shared_ptr<RenderJob> &a, const std::shared_ptr<RenderJob> &b)
+            {
+                if (a->m_cancelled != b->m_cancelled)
+                    return (bool)a->m_cancelled;
+
+                if (a->m_options.m_priority != b->m_options.m_priority)
+                    return a->m_options.m_priority > b->m_options.m_priority;
+
+                return a->m_sequence < b->m_sequence;
+            };
+
+            return *std::min_element(m_jobs.begin(), m_jobs.end(), before);
+        }
+
+        void dispatch()
+        {
+            for (;;)
+            {
+                std::shared_ptr<RenderJob> job;
+
+                {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    m_job_added.wait(lock, [this]()
+                                     { return m_stopping || !m_jobs.empty(); });
+
+                    if (m_jobs.empty())
+                        return;
+
+                    job = pick_job();
+                }
+
+                if (!job->m_cancelled)
+                    run_chunk(*job);
+
+                if (job->m_cancelled || job->m_next_tile == job->m_tiles.size())
+                    finish(job);
+            }
+        }
+
+        // renders the next few tiles of the job, a couple per worker
+        void run_chunk(RenderJob &job)
+        {
+            PROFILE_FUNCTION();
+
+            job.m_status = RenderJobStatus::Running;
+
+            const size_t first = job.m_next_tile;
+            const size_t count = std::min(job.m_tiles.size() - first, (size_t)std::max(job.m_options.m_thread_count, 1) * 2);
+
+            ThreadPool::Get().run(
+                count, [&](const size_t index, [[maybe_unused]] const int worker_index)
+                {
+                    if (job.m_cancelled)
+                        return;
+
+                    const Tile &tile = job.m_tiles[first + index];
+
+                    const uint64_t samples_taken = job.m_camera.render_tile(job.m_world, tile, job.m_image.get());
+
+                    job.m_tiles_done++;
+                    job.m_samples_done += samples_taken; },
+                job.m_options.m_thread_count);
+
+            job.m_next_tile = first + count;
+        }
+
+        void finish(const std::shared_ptr<RenderJob> &job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), job));
+            }
+
+            // handles keep the job alive, only the image is needed from here on
+            job->m_world = World();
+
+            if (job->m_cancelled)
+            {
+                job->m_status = RenderJobStatus::Cancelled;
+                job->m_promise.set_value(nullptr);
+            }
+            else
+            {
+                job->m_status = RenderJobStatus::Finished;
+                job->m_promise.set_value(job->m_image);
+            }
+        }
+
+        std::thread m_dispatcher;
+
+        mutable std::mutex m_lock; // guards everything below
+        std::condition_variable m_job_added;
+        std::vector<std::shared_ptr<RenderJob>> m_jobs;
+        uint64_t m_sequence = 0;
+        bool m_stopping = false;
+    };
+} // namespace Karbon
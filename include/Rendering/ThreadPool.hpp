@@ -0,0 +1,218 @@
+#pragma once
+
+#include "Constants.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief Persistent pool of worker threads with per-worker work-stealing queues
+     *
+     * A batch of task indices is split into contiguous runs, one per participating worker. Every
+     * worker pops from the front of its own queue and, once that runs dry, steals from the back of
+     * the other queues, so neighbouring tasks stay on the same thread while the tail of the batch
+     * gets balanced across everyone.
+     */
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void(const size_t task_index, const int worker_index)>;
+
+        explicit ThreadPool(const int thread_count = kCORE_COUNT)
+        {
+            const int count = std::max(1, thread_count);
+
+            m_queues.reserve(static_cast<size_t>(count));
+
+            for (int i = 0; i < count; i++)
+                m_queues.emplace_back(std::make_unique<WorkQueue>());
+
+            for (int i = 0; i < count; i++)
+                m_workers.emplace_back([this, i]()
+                                       { worker_loop(i); });
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_stopping = true;
+            }
+
+            m_batch_ready.notify_all();
+
+            for (auto &worker : m_workers)
+                worker.join();
+        }
+
+        /**
+         * @brief Get the shared pool, created on first use with one worker per core
+         *
+         * @return ThreadPool&
+         */
+        static ThreadPool &Get()
+        {
+            static ThreadPool instance(kCORE_COUNT);
+            return instance;
+        }
+
+        [[nodiscard]] int size() const noexcept
+        {
+            return (int)m_workers.size();
+        }
+
+        /**
+         * @brief Runs task(index, worker) for every index in [0, task_count) and blocks until all are done
+         *
+         * Batches from different callers are serialized.
+         *
+         * @param task_count Number of tasks in the batch
+         * @param task The function to run for every task
+         * @param max_workers Upper bound on the number of workers taking part in this batch, more than size() run as
+         * size(), so callers that report a thread count should clamp it first
+         */
+        void run(const size_t task_count, const Task &task, const int max_workers = std::numeric_limits<int>::max())
+        {
+            PROFILE_FUNCTION();
+
+            if (task_count == 0)
+                return;
+
+            std::lock_guard<std::mutex> batch_guard(m_batch_lock);
+
+            const int worker_count = std::clamp(max_workers, 1, size());
+            const size_t queue_count = static_cast<size_t>(worker_count);
+
+            // contiguous runs keep tasks that are close in index (and usually in space) on one worker
+            for (size_t i = 0; i < queue_count; i++)
+            {
+                const size_t begin = task_count * i / queue_count;
+                const size_t end = task_count * (i + 1) / queue_count;
+
+                std::lock_guard<std::mutex> lock(m_queues[i]->m_lock);
+                for (size_t t = begin; t < end; t++)
+                    m_queues[i]->m_tasks.push_back(t);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+                m_task = &task;
+                m_worker_count = worker_count;
+                m_remaining = task_count;
+                m_generation++;
+            }
+
+            m_batch_ready.notify_all();
+
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_batch_done.wait(lock, [this]()
+                              { return m_remaining == 0 && m_active_workers == 0; });
+
+            m_task = nullptr;
+        }
+
+    private:
+        struct WorkQueue
+        {
+            std::mutex m_lock;
+            std::deque<size_t> m_tasks;
+        };
+
+        [[nodiscard]] bool pop_local(const int worker_index, size_t &task_index)
+        {
+            WorkQueue &queue = *m_queues[static_cast<size_t>(worker_index)];
+            std::lock_guard<std::mutex> lock(queue.m_lock);
+
+            if (queue.m_tasks.empty())
+                return false;
+
+            task_index = queue.m_tasks.front();
+            queue.m_tasks.pop_front();
+
+            return true;
+        }
+
+        [[nodiscard]] bool steal(const int worker_index, const int worker_count, size_t &task_index)
+        {
+            for (int offset = 1; offset < worker_count; offset++)
+            {
+                WorkQueue &victim = *m_queues[static_cast<size_t>((worker_index + offset) % worker_count)];
+                std::lock_guard<std::mutex> lock(victim.m_lock);
+
+                if (victim.m_tasks.empty())
+                    continue;
+
+                task_index = victim.m_tasks.back();
+                victim.m_tasks.pop_back();
+
+                return true;
+            }
+
+            return false;
+        }
+
+        void worker_loop(const int worker_index)
+        {
+            uint64_t seen_generation = 0;
+
+            while (true)
+            {
+                const Task *task = nullptr;
+                int worker_count = 0;
+
+                {
+                    std::unique_lock<std::mutex> lock(m_lock);
+                    m_batch_ready.wait(lock, [&]()
+                                       { return m_stopping || m_generation != seen_generation; });
+
+                    if (m_stopping)
+                        return;
+
+                    seen_generation = m_generation;
+
+                    // not part of this batch, or woke up after the batch already finished
+                    if (worker_index >= m_worker_count || m_task == nullptr)
+                        continue;
+
+                    task = m_task;
+                    worker_count = m_worker_count;
+                    m_active_workers++;
+                }
+
+                size_t task_index;
+                size_t finished = 0;
+
+                while (pop_local(worker_index, task_index) || steal(worker_index, worker_count, task_index))
+                {
+                    (*task)(task_index, worker_index);
+                    finished++;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_lock);
+                    m_remaining -= finished;
+                    m_active_workers--;
+                }
+
+                m_batch_done.notify_all();
+            }
+        }
+
+        std::vector<std::thread> m_workers;
+        std::vector<std::unique_ptr<WorkQueue>> m_queues;
+
+        std::mutex m_batch_lock; // one batch at a time
+
+        std::mutex m_lock; // guards everything below
+        std::condition_variable m_batch_ready;
+        std::condition_variable m_batch_done;
+        const Task *m_task = nullptr;
+        int m_worker_count = 0;
+        int m_active_workers = 0;
+        size_t m_remaining = 0;
+        uint64_t m_generation = 0;
+        bool m_stopping = false;
+    };
+} // namespace Karbon
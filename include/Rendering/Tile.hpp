@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Constants.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief Rectangle of pixels rendered as one unit of work, [x0, x1) x [y0, y1)
+     *
+     */
+    struct Tile
+    {
+        [[nodiscard]] constexpr int width() const noexcept
+        {
+            return m_x1 - m_x0;
+        }
+
+        [[nodiscard]] constexpr int height() const noexcept
+        {
+            return m_y1 - m_y0;
+        }
+
+        [[nodiscard]] constexpr int pixel_count() const noexcept
+        {
+            return width() * height();
+        }
+
+        int m_x0 = 0;
+        int m_y0 = 0;
+        int m_x1 = 0;
+        int m_y1 = 0;
+    };
+
+    /**
+     * @brief Timing of one rendered tile, used to inspect how well the work was balanced
+     *
+     */
+    struct TileStats
+    {
+        Tile m_tile;
+        int m_worker = 0;
+        float m_millis = 0;
+        uint64_t m_samples = 0; // camera samples traced, fewer than pixels * antialiasing_samples with adaptive sampling
+    };
+
+    enum class TileOrder
+    {
+        Scanline,
+        Morton,
+        Hilbert,
+    };
+
+    // interleaves the lower 16 bits of x and y (x in the even bits)
+    [[nodiscard]] constexpr uint32_t morton_code(uint32_t x, uint32_t y) noexcept
+    {
+        auto spread = [](uint32_t v)
+        {
+            v &= 0x0000ffff;
+            v = (v | (v << 8)) & 0x00ff00ff;
+            v = (v | (v << 4)) & 0x0f0f0f0f;
+            v = (v | (v << 2)) & 0x33333333;
+            v = (v | (v << 1)) & 0x55555555;
+            return v;
+        };
+
+        return spread(x) | (spread(y) << 1);
+    }
+
+    // distance along a Hilbert curve covering a n x n grid (n a power of two)
+    [[nodiscard]] constexpr uint32_t hilbert_index(const uint32_t n, uint32_t x, uint32_t y) noexcept
+    {
+        uint32_t d = 0;
+
+        for (uint32_t s = n / 2; s > 0; s /= 2)
+        {
+            uint32_t rx = (x & s) > 0;
+            uint32_t ry = (y & s) > 0;
+
+            d += s * s * ((3 * rx) ^ ry);
+
+            if (ry == 0)
+            {
+                if (rx == 1)
+                {
+                    x = n - 1 - x;
+                    y = n - 1 - y;
+                }
+
+                std::swap(x, y);
+            }
+        }
+
+        return d;
+    }
+
+    /**
+     * @brief Splits an image into tiles, ordered so consecutive tiles are close to each other
+     *
+     * @param width Width of the image in pixels
+     * @param height Height of the image in pixels
+     * @param tile_size Edge length of a tile, tiles on the right/bottom border are clipped
+     * @param order The order the tiles are returned in
+     * @return std::vector<Tile>
+     */
+    [[nodiscard]] inline std::vector<Tile> make_tiles(const int width, const int height, const int tile_size, const TileOrder order = TileOrder::Morton)
+    {
+        const int size = std::max(1, tile_size);
+        const int tiles_x = (width + size - 1) / size;
+        const int tiles_y = (height + size - 1) / size;
+
+        std::vector<std::pair<uint32_t, Tile>> keyed_tiles;
+        keyed_tiles.reserve((size_t)tiles_x * (size_t)tiles_y);
+
+        uint32_t grid = 1;
+        while (grid < (uint32_t)std::max(tiles_x, tiles_y))
+            grid *= 2;
+
+        for (int ty = 0; ty < tiles_y; ty++)
+        {
+            for (int tx = 0; tx < tiles_x; tx++)
+            {
+                Tile tile{tx * size, ty * size, std::min(width, (tx + 1) * size), std::min(height, (ty + 1) * size)};
+
+                uint32_t key = 0;
+
+                switch (order)
+                {
+                case TileOrder::Scanline:
+                    key = (uint32_t)(ty * tiles_x + tx);
+                    break;
+                case TileOrder::Morton:
+                    key = morton_code((uint32_t)tx, (uint32_t)ty);
+                    break;
+                case TileOrder::Hilbert:
+                    key = hilbert_index(grid, (uint32_t)tx, (uint32_t)ty);
+                    break;
+                }
+
+                keyed_tiles.emplace_back(key, tile);
+            }
+        }
+
+        std::sort(keyed_tiles.begin(), keyed_tiles.end(), [](const auto &a, const auto &b)
+                  { return a.first < b.first; });
+
+        std::vector<Tile> tiles;
+        tiles.reserve(keyed_tiles.size());
+
+        for (const auto &keyed_tile : keyed_tiles)
+            tiles.emplace_back(keyed_tile.second);
+
+        return tiles;
+    }
+} // namespace Karbon
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "Acceleration/Hit.hpp"
+#include "Acceleration/RayPacket.hpp"
+#include "Constants.hpp"
+#include "Materials/MaterialTable.hpp"
+#include "Ray.hpp"
+#include "Sampling/Sampler.hpp"
+#include "Tuples/Color.hpp"
+#include "World.hpp"
+
+namespace Karbon
+{
+    // state of one path between the stages of a Wavefront
+    struct WavefrontPath
+    {
+        Ray m_ray;
+        Color m_throughput = Karbon::WHITE;
+        Hit m_hit;
+        uint32_t m_pixel = 0; // index into the radiance buffer of the wave
+        Sampler m_sampler;    // the sample values of the camera sample the path started as
+    };
+
+    /**
+     * @brief Traces a large batch of paths one stage at a time instead of one path at a time
+     *
+     * Every bounce runs intersect -> sort by material -> shade/scatter -> compact over the whole batch, so each stage
+     * keeps its code and data hot and the shading stage walks runs of paths that hit the same material. The buffers
+     * are kept between waves, one Wavefront per worker avoids reallocating them for every tile.
+     */
+    struct Wavefront
+    {
+        // paths traced together, large enough for long material runs and small enough for the buffers to stay in cache
+        static constexpr size_t kMaxPaths = 8192;
+
+        [[nodiscard]] Wavefront() = default;
+
+        // clears the radiance of `pixel_count` pixels, the waves traced afterwards add to it
+        void reset(const size_t pixel_count)
+        {
+            m_paths.clear();
+            m_radiance.assign(pixel_count, Color());
+        }
+
+        // generate stage, camera rays added in 4x4 block order let the first intersect stage use packets
+        void add_path(const Ray &ray, const uint32_t pixel, const Sampler &sampler)
+        {
+            assert(pixel < m_radiance.size());
+
+            WavefrontPath &path = m_paths.emplace_back();
+            path.m_ray = ray;
+            path.m_pixel = pixel;
+            path.m_sampler = sampler;
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return m_paths.size();
+        }
+
+        /**
+         * @brief Runs the stages until every path has ended, the light they gather is summed per pixel
+         *
+         * @param w The world to trace
+         * @param packets Trace the first bounce in RayPacket sized groups
+         */
+        void trace(const World &w, const bool packets)
+        {
+            rank_materials(w.get_materials());
+
+            for (int depth = 0; depth <= w.get_max_recurtion_level() && !m_paths.empty(); depth++)
+            {
+                intersect(w, packets && depth == 0);
+                sort();
+                shade(w, depth);
+            }
+
+            // paths still alive past the bounce limit gather no more light
+            m_paths.clear();
+        }
+
+        // light gathered by the paths of `pixel`, summed over its samples
+        [[nodiscard]] const Color &get_radiance(const uint32_t pixel) const noexcept
+        {
+            return m_radiance[pixel];
+        }
+
+    private:
+        // sort bins ordered by material class, so the shade stage sees every Diffuse material, then Metal, ...
+        void rank_materials(const MaterialTable &materials)
+        {
+            const uint32_t count = materials.size();
+
+            m_material_bin.resize(count);
+
+            uint32_t bin = 1; // bin 0 collects the misses
+
+            for (size_t kind = 0; kind < (size_t)MaterialKind::Count; kind++)
+                for (uint32_t material = 0; material < count; material++)
+                    if (materials.get_kind(material) == (MaterialKind)kind)
+                        m_material_bin[material] = bin++;
+
+            m_bin_offsets.resize((size_t)count + 2);
+        }
+
+        [[nodiscard]] uint32_t bin_of(const WavefrontPath &path) const noexcept
+        {
+            return path.m_hit.is_valid() ? m_material_bin[path.m_hit.m_object->get_material_index()] : 0;
+        }
+
+        void intersect(const World &w, const bool packets)
+        {
+            PROFILE_FUNCTION();
+
+            const size_t count = m_paths.size();
+
+            if (!packets)
+            {
+                for (auto &path : m_paths)
+                    path.m_hit = w.closest_hit(path.m_ray);
+
+                return;
+            }
+
+            for (size_t first = 0; first < count; first += RayPacket::kSize)
+            {
+                const uint32_t group = (uint32_t)std::min<size_t>(RayPacket::kSize, count - first);
+
+                m_packet.clear();
+
+                for (uint32_t i = 0; i < group; i++)
+                    m_packet.set(i, m_paths[first + i].m_ray);
+
+                w.closest_hit(m_packet, m_packet_hits);
+
+                for (uint32_t i = 0; i < group; i++)
+                    m_paths[first + i].m_hit = m_packet_hits[i];
+            }
+        }
+
+        // counting sort of the path indices by material bin, stable so coherent neighbours stay together
+        void sort()
+        {
+            PROFILE_FUNCTION();
+
+            std::fill(m_bin_offsets.begin(), m_bin_offsets.end(), 0);
+
+            m_bins.resize(m_paths.size());
+
+            for (size_t i = 0; i < m_paths.size(); i++)
+            {
+                m_bins[i] = bin_of(m_paths[i]);
+                m_bin_offsets[m_bins[i] + 1]++;
+            }
+
+            for (size_t bin = 1; bin < m_bin_offsets.size(); bin++)
+                m_bin_offsets[bin] += m_bin_offsets[bin - 1];
+
+            m_order.resize(m_paths.size());
+
+            for (uint32_t i = 0; i < (uint32_t)m_paths.size(); i++)
+                m_order[m_bin_offsets[m_bins[i]]++] = i;
+        }
+
+        // shades the paths in sorted order and compacts the survivors into the next bounce
+        void shade(const World &w, const int depth)
+        {
+            PROFILE_FUNCTION();
+
+            m_next.clear();
+
+            for (const uint32_t index : m_order)
+            {
+                WavefrontPath &path = m_paths[index];
+
+                if (!path.m_hit.is_valid())
+                {
+                    m_radiance[path.m_pixel] += path.m_throughput * World::sky_color(path.m_ray);
+                    continue;
+                }
+
+                if (w.continue_path(path.m_hit, depth, path.m_ray, path.m_throughput, m_radiance[path.m_pixel], path.m_sampler))
+                    m_next.emplace_back(path);
+            }
+
+            std::swap(m_paths, m_next);
+        }
+
+        std::vector<WavefrontPath> m_paths; // paths alive at the current bounce
+        std::vector<WavefrontPath> m_next;  // survivors of the shade stage, in material order
+        std::vector<uint32_t> m_bins;       // material bin of every path
+        std::vector<uint32_t> m_order;      // path indices grouped by material bin
+        std::vector<uint32_t> m_material_bin;
+        std::vector<uint32_t> m_bin_offsets;
+        std::vector<Color> m_radiance;
+
+        RayPacket m_packet;
+        PacketHits m_packet_hits;
+    };
+} // namespace Karbon
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "Tuples/Color.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief Running mean and variance of the samples of one pixel (Welford's algorithm on the luminance)
+     *
+     * The color sum is kept as well, it is what the pixel resolves to.
+     */
+    struct PixelEstimate
+    {
+        // c is a sample color in the 0-255 range of World::color_at
+        void add(const Color &c) noexcept
+        {
+            m_sum += c;
+            m_count++;
+
+            const float luminance = (0.2126f * c.r + 0.7152f * c.g + 0.0722f * c.b) * (1.0f / 255.0f);
+            const float delta = luminance - m_mean;
+
+            m_mean += delta / (float)m_count;
+            m_m2 += delta * (luminance - m_mean);
+        }
+
+        /**
+         * @brief Standard error of the pixel as it will be displayed, after gamma correction, in 0-1 units
+         *
+         * The standard error of the mean luminance is scaled by the slope of the 1/2.2 gamma curve at the mean, so
+         * noise in dark pixels (which gamma correction brightens) counts more than the same noise in bright ones.
+         */
+        [[nodiscard]] float display_error() const noexcept
+        {
+            if (m_count < 2)
+                return std::numeric_limits<float>::infinity();
+
+            const float variance = m_m2 / (float)(m_count - 1);
+            const float standard_error = std::sqrt(variance / (float)m_count);
+
+            // the slope goes to infinity at black, a pixel that dark is as good as black
+            const float mean = std::max(m_mean, 1.0f / 255.0f);
+
+            return standard_error * (1.0f / 2.2f) * std::pow(mean, 1.0f / 2.2f - 1.0f);
+        }
+
+        Color m_sum;
+        int m_count = 0;
+        float m_mean = 0; // luminance, 0-1
+        float m_m2 = 0;   // sum of squared deviations from the mean
+    };
+
+    /**
+     * @brief Settings of adaptive sampling: pixels stop taking samples once their estimated error is low enough
+     *
+     * World::antialiasing_samples is the maximum a pixel may take. Every pixel takes at least m_min_samples, then its
+     * error is checked every m_min_samples samples, so flat regions stop early and the budget goes to noisy ones.
+     */
+    struct AdaptiveSampling
+    {
+        // true if a pixel with this estimate has enough samples
+        [[nodiscard]] bool is_converged(const PixelEstimate &estimate) const noexcept
+        {
+            const int batch = std::max(m_min_samples, 2);
+
+            if (!m_enabled || estimate.m_count < batch || estimate.m_count % batch != 0)
+                return false;
+
+            return estimate.display_error() <= m_threshold;
+        }
+
+        bool m_enabled = false;
+        int m_min_samples = 16;
+        float m_threshold = 0.005f; // standard error of the displayed pixel, about 1.3 of 255 levels
+    };
+} // namespace Karbon
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Karbon
+{
+    /**
+     * @brief Counter-based random numbers, draw n is a hash of (key, n) so there is no state besides the counter
+     *
+     * Sampler's Random kind keys one by pixel and sample index and skips to the dimension it reads, so the numbers a path
+     * sees don't depend on which thread traces it or in which order the tiles are scheduled: renders are identical for
+     * any thread count. The mixing function is the SplitMix64 finalizer, a handful of multiplies and shifts per draw.
+     */
+    struct Rng
+    {
+        [[nodiscard]] constexpr Rng() = default;
+
+        [[nodiscard]] constexpr explicit Rng(const uint64_t key) noexcept : m_key(mix(key)) {}
+
+        // the generator of one camera sample
+        [[nodiscard]] constexpr Rng(const uint32_t pixel, const uint32_t sample) noexcept : Rng(((uint64_t)sample << 32) | pixel) {}
+
+        [[nodiscard]] constexpr uint64_t next_u64() noexcept
+        {
+            return mix(m_key + ++m_counter * 0x9e3779b97f4a7c15ull);
+        }
+
+        [[nodiscard]] constexpr uint32_t next_u32() noexcept
+        {
+            return (uint32_t)(next_u64() >> 32);
+        }
+
+        // uniform in [0, 1), 24 random bits so 1 can never be returned
+        [[nodiscard]] constexpr float next_float() noexcept
+        {
+            return (float)(next_u32() >> 8) * (1.0f / 16777216.0f);
+        }
+
+        // uniform in [min, max)
+        [[nodiscard]] constexpr float uniform(const float min, const float max) noexcept
+        {
+            return min + (max - min) * next_float();
+        }
+
+        // moves ahead `count` draws without computing them
+        constexpr void skip(const uint64_t count) noexcept
+        {
+            m_counter += count;
+        }
+
+        // number of draws made so far
+        [[nodiscard]] constexpr uint64_t get_counter() const noexcept
+        {
+            return m_counter;
+        }
+
+    private:
+        [[nodiscard]] static constexpr uint64_t mix(uint64_t z) noexcept
+        {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t m_key = 0;
+        uint64_t m_counter = 0;
+    };
+} // namespace Karbon
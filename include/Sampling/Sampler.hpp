@@ -0,0 +1,396 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "Sampling/Rng.hpp"
+
+namespace Karbon
+{
+    enum class SamplerKind
+    {
+        Random,     // independent uniform numbers
+        Stratified, // jittered strata over the pixel's samples, shuffled per dimension
+        Sobol,      // Owen-scrambled Sobol points, padded and scrambled per dimension pair
+        BlueNoise,  // Sobol points shared by all pixels, shifted per pixel by a blue noise mask
+        Count,
+    };
+
+    [[nodiscard]] constexpr const char *sampler_kind_name(const SamplerKind kind) noexcept
+    {
+        switch (kind)
+        {
+        case SamplerKind::Random:
+            return "Random";
+        case SamplerKind::Stratified:
+            return "Stratified";
+        case SamplerKind::Sobol:
+            return "Sobol";
+        case SamplerKind::BlueNoise:
+            return "BlueNoise";
+        default:
+            return "Unknown";
+        }
+    }
+
+    // case-insensitive inverse of sampler_kind_name, false if `name` is no sampler
+    [[nodiscard]] inline bool sampler_kind_from_name(const std::string &name, SamplerKind &kind)
+    {
+        for (int i = 0; i < (int)SamplerKind::Count; i++)
+        {
+            const std::string candidate = sampler_kind_name((SamplerKind)i);
+
+            if (std::equal(name.begin(), name.end(), candidate.begin(), candidate.end(), [](const char a, const char b)
+                           { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); }))
+            {
+                kind = (SamplerKind)i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    namespace SamplerDetail
+    {
+        // lowbias32 by Chris Wellons, a cheap 32-bit hash with good avalanche
+        [[nodiscard]] constexpr uint32_t hash(uint32_t x) noexcept
+        {
+            x ^= x >> 16;
+            x *= 0x7feb352du;
+            x ^= x >> 15;
+            x *= 0x846ca68bu;
+            x ^= x >> 16;
+            return x;
+        }
+
+        [[nodiscard]] constexpr uint32_t hash(const uint32_t a, const uint32_t b) noexcept
+        {
+            return hash(a ^ hash(b + 0x9e3779b9u));
+        }
+
+        [[nodiscard]] constexpr uint32_t reverse_bits(uint32_t x) noexcept
+        {
+            x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+            x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+            x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+            x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+            return (x >> 16) | (x << 16);
+        }
+
+        // Laine-Karras permutation, every bit only depends on the bits below it: on a bit reversed value it is a random
+        // permutation of every node of the base 2 digit tree, which is hash-based Owen scrambling (Burley 2020)
+        [[nodiscard]] constexpr uint32_t laine_karras(uint32_t x, const uint32_t seed) noexcept
+        {
+            x += seed;
+            x ^= x * 0x6c50b47cu;
+            x ^= x * 0xb82f1e52u;
+            x ^= x * 0xc7afe638u;
+            x ^= x * 0x8d22f6e6u;
+            return x;
+        }
+
+        /**
+         * @brief The second dimension of the Sobol sequence with index and result bit reversed
+         *
+         * The first dimension is the bit reversed index, so working on reversed values saves the reversals around the
+         * scrambles. The generator matrix is applied with four byte lookups, shuffled indices use all 32 bits.
+         */
+        inline constexpr auto kSobol1Tables = []()
+        {
+            std::array<std::array<uint32_t, 256>, 4> tables = {};
+
+            // the direction numbers, v_k = v_(k-1) ^ (v_(k-1) >> 1)
+            uint32_t directions[32] = {};
+            directions[0] = 1u << 31;
+
+            for (int k = 1; k < 32; k++)
+                directions[k] = directions[k - 1] ^ (directions[k - 1] >> 1);
+
+            // bit j of a reversed index is bit 31 - j of the index
+            for (size_t byte = 0; byte < 4; byte++)
+                for (uint32_t value = 0; value < 256; value++)
+                    for (size_t bit = 0; bit < 8; bit++)
+                        if (value & (1u << bit))
+                            tables[byte][value] ^= reverse_bits(directions[31 - (byte * 8 + bit)]);
+
+            return tables;
+        }();
+
+        [[nodiscard]] constexpr uint32_t sobol_1_reversed(const uint32_t reversed_index) noexcept
+        {
+            return kSobol1Tables[0][reversed_index & 0xff] ^ kSobol1Tables[1][(reversed_index >> 8) & 0xff] ^ kSobol1Tables[2][(reversed_index >> 16) & 0xff] ^ kSobol1Tables[3][reversed_index >> 24];
+        }
+
+        // Kensler's hashed permutation of [0, length), a shuffle without a table
+        [[nodiscard]] constexpr uint32_t permute(uint32_t i, const uint32_t length, const uint32_t seed) noexcept
+        {
+            uint32_t w = length - 1;
+            w |= w >> 1;
+            w |= w >> 2;
+            w |= w >> 4;
+            w |= w >> 8;
+            w |= w >> 16;
+
+            do
+            {
+                i ^= seed;
+                i *= 0xe170893du;
+                i ^= seed >> 16;
+                i ^= (i & w) >> 4;
+                i ^= seed >> 8;
+                i *= 0x0929eb3fu;
+                i ^= seed >> 23;
+                i ^= (i & w) >> 1;
+                i *= 1 | seed >> 27;
+                i *= 0x6935fa69u;
+                i ^= (i & w) >> 11;
+                i *= 0x74dcb303u;
+                i ^= (i & w) >> 2;
+                i *= 0x9e501cc3u;
+                i ^= (i & w) >> 2;
+                i *= 0xc860a3dfu;
+                i &= w;
+                i ^= i >> 5;
+            } while (i >= length);
+
+            return (i + seed) % length;
+        }
+
+        // the upper 24 bits as a float in [0, 1)
+        [[nodiscard]] constexpr float to_float(const uint32_t bits) noexcept
+        {
+            return (float)(bits >> 8) * (1.0f / 16777216.0f);
+        }
+
+        [[nodiscard]] inline float wrap(const float x) noexcept
+        {
+            return x >= 1.0f ? x - 1.0f : x;
+        }
+
+        static constexpr int kBlueNoiseSize = 64;
+
+        /**
+         * @brief A kBlueNoiseSize^2 tileable blue noise mask, every texel holds its rank in [0, 1)
+         *
+         * Built once on first use with void-and-cluster (Ulichney 1993): starting from one texel, the texel in the
+         * largest void (lowest gaussian energy of the texels ranked so far) gets the next rank. Any threshold of the
+         * mask is then an evenly spread point set, so neighbouring pixels get well separated values.
+         */
+        [[nodiscard]] inline const std::vector<float> &blue_noise_mask()
+        {
+            static const std::vector<float> mask = []()
+            {
+                constexpr size_t n = kBlueNoiseSize;
+                constexpr float sigma = 1.5f;
+
+                // toroidal gaussian, indexed by the wrapped offset between two texels
+                std::vector<float> kernel(n * n);
+
+                for (size_t y = 0; y < n; y++)
+                    for (size_t x = 0; x < n; x++)
+                    {
+                        const float dx = (float)std::min(x, n - x);
+                        const float dy = (float)std::min(y, n - y);
+                        kernel[y * n + x] = std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+                    }
+
+                std::vector<float> energy(n * n, 0.0f);
+                std::vector<float> ranks(n * n, -1.0f);
+
+                for (size_t rank = 0; rank < n * n; rank++)
+                {
+                    size_t best = n * n;
+
+                    for (size_t i = 0; i < n * n; i++)
+                        if (ranks[i] < 0 && (best == n * n || energy[i] < energy[best]))
+                            best = i;
+
+                    ranks[best] = ((float)rank + 0.5f) / (float)(n * n);
+
+                    const size_t bx = best % n;
+                    const size_t by = best / n;
+
+                    for (size_t y = 0; y < n; y++)
+                        for (size_t x = 0; x < n; x++)
+                            energy[y * n + x] += kernel[((y + n - by) % n) * n + (x + n - bx) % n];
+                }
+
+                return ranks;
+            }();
+
+            return mask;
+        }
+    } // namespace SamplerDetail
+
+    /**
+     * @brief The sample values of one camera sample: pixel (x, y), sample `sample` of `sample_count`
+     *
+     * Every random decision of a path reads the next dimension of its Sampler. The camera jitter uses the first
+     * kCameraDimensions, then every bounce starts at a fixed dimension (start_bounce) so a path that takes a different
+     * branch doesn't shift the dimensions of the bounces after it. All kinds are counter based like Rng, the values
+     * only depend on (pixel, sample, dimension), so renders stay identical for any thread count and tile order.
+     *
+     * Stratified and Sobol spread the samples of a pixel evenly over every dimension (pair), so the per pixel error
+     * falls faster than with Random. BlueNoise uses the same Sobol points for all pixels and offsets them by a blue
+     * noise mask, spreading the remaining error as high frequency noise that is hard to see at low sample counts.
+     */
+    struct Sampler
+    {
+        static constexpr uint32_t kCameraDimensions = 2; // pixel jitter
+        // [0, 1] scatter (the direction, or the reflect/refract choice of a dielectric in [0]), [2] unused, [3] russian
+        // roulette, [4] light choice
+        static constexpr uint32_t kBounceDimensions = 5;
+        static constexpr uint32_t kRouletteDimension = 3;
+        static constexpr uint32_t kLightDimension = 4;
+
+        [[nodiscard]] Sampler() = default;
+
+        /**
+         * @param kind How the values are distributed
+         * @param x Column of the pixel
+         * @param y Row of the pixel
+         * @param sample Index of the sample in the pixel
+         * @param sample_count Samples the pixel gets, 0 if open ended (progressive rendering), Stratified falls back to Random then
+         */
+        [[nodiscard]] Sampler(const SamplerKind kind, const uint32_t x, const uint32_t y, const uint32_t sample, const uint32_t sample_count) noexcept
+            : m_kind(kind), m_x(x), m_y(y), m_pixel_seed(SamplerDetail::hash(x, y)), m_sample(sample), m_sample_count(sample_count)
+        {
+        }
+
+        [[nodiscard]] constexpr SamplerKind get_kind() const noexcept
+        {
+            return m_kind;
+        }
+
+        // the next dimension reads will start from
+        [[nodiscard]] constexpr uint32_t get_dimension() const noexcept
+        {
+            return m_dimension;
+        }
+
+        void set_dimension(const uint32_t dimension) noexcept
+        {
+            m_dimension = dimension;
+        }
+
+        // moves to dimension `offset` of bounce `depth`
+        void start_bounce(const int depth, const uint32_t offset = 0) noexcept
+        {
+            m_dimension = kCameraDimensions + (uint32_t)depth * kBounceDimensions + offset;
+        }
+
+        // the next dimension, in [0, 1)
+        [[nodiscard]] float get_1d() noexcept
+        {
+            const uint32_t dimension = m_dimension++;
+
+            switch (m_kind)
+            {
+            case SamplerKind::Stratified:
+                if (m_sample_count > 1 && m_sample < m_sample_count)
+                {
+                    const uint32_t stratum = SamplerDetail::permute(m_sample, m_sample_count, seed(dimension));
+                    return ((float)stratum + random(dimension)) / (float)m_sample_count;
+                }
+                return random(dimension);
+            case SamplerKind::Sobol:
+                return SamplerDetail::to_float(sobol(dimension, m_pixel_seed).first);
+            case SamplerKind::BlueNoise:
+                return SamplerDetail::wrap(SamplerDetail::to_float(sobol(dimension, 0).first) + mask(dimension));
+            default:
+                return random(dimension);
+            }
+        }
+
+        // the next two dimensions, stratified jointly by the kinds that can
+        void get_2d(float &u, float &v) noexcept
+        {
+            const uint32_t dimension = m_dimension;
+            m_dimension += 2;
+
+            switch (m_kind)
+            {
+            case SamplerKind::Stratified:
+                if (m_sample_count > 1 && m_sample < m_sample_count)
+                {
+                    // the smallest grid with a cell per sample, when it has spare cells some of them stay empty
+                    const uint32_t columns = (uint32_t)std::ceil(std::sqrt((float)m_sample_count));
+                    const uint32_t rows = (m_sample_count + columns - 1) / columns;
+                    const uint32_t cell = SamplerDetail::permute(m_sample, columns * rows, seed(dimension));
+
+                    u = ((float)(cell % columns) + random(dimension)) / (float)columns;
+                    v = ((float)(cell / columns) + random(dimension + 1)) / (float)rows;
+                    return;
+                }
+                u = random(dimension);
+                v = random(dimension + 1);
+                return;
+            case SamplerKind::Sobol:
+            {
+                const auto [a, b] = sobol(dimension, m_pixel_seed);
+                u = SamplerDetail::to_float(a);
+                v = SamplerDetail::to_float(b);
+                return;
+            }
+            case SamplerKind::BlueNoise:
+            {
+                const auto [a, b] = sobol(dimension, 0);
+                u = SamplerDetail::wrap(SamplerDetail::to_float(a) + mask(dimension));
+                v = SamplerDetail::wrap(SamplerDetail::to_float(b) + mask(dimension + 1));
+                return;
+            }
+            default:
+                u = random(dimension);
+                v = random(dimension + 1);
+                return;
+            }
+        }
+
+    private:
+        [[nodiscard]] uint32_t seed(const uint32_t dimension) const noexcept
+        {
+            return SamplerDetail::hash(m_pixel_seed, dimension);
+        }
+
+        // an independent uniform number per (pixel, sample, dimension)
+        [[nodiscard]] float random(const uint32_t dimension) const noexcept
+        {
+            Rng rng(m_pixel_seed, m_sample);
+            rng.skip(dimension);
+            return rng.next_float();
+        }
+
+        // a 2D Sobol point, the sample index is shuffled and the point Owen-scrambled per dimension pair so the pairs are decorrelated
+        [[nodiscard]] std::pair<uint32_t, uint32_t> sobol(const uint32_t dimension, const uint32_t pixel_seed) const noexcept
+        {
+            using namespace SamplerDetail;
+
+            const uint32_t dimension_seed = hash(pixel_seed, dimension);
+
+            // the shuffled index, bit reversed, which is also its first dimension
+            const uint32_t index = laine_karras(reverse_bits(m_sample), dimension_seed);
+
+            return {reverse_bits(laine_karras(reverse_bits(index), hash(dimension_seed))),
+                    reverse_bits(laine_karras(sobol_1_reversed(index), hash(dimension_seed ^ 0x68bc21ebu)))};
+        }
+
+        // the blue noise value of this pixel for `dimension`, every dimension reads the mask at its own toroidal offset
+        [[nodiscard]] float mask(const uint32_t dimension) const noexcept
+        {
+            constexpr uint32_t size = (uint32_t)SamplerDetail::kBlueNoiseSize;
+
+            const uint32_t offset = SamplerDetail::hash(dimension + 0x5f3759dfu);
+            const uint32_t x = (m_x + offset) & (size - 1);
+            const uint32_t y = (m_y + (offset >> 16)) & (size - 1);
+
+            return SamplerDetail::blue_noise_mask()[y * size + x];
+        }
+
+        SamplerKind m_kind = SamplerKind::Random;
+        uint32_t m_x = 0;
+        uint32_t m_y = 0;
+        uint32_t m_pixel_seed = 0;
+        uint32_t m_sample = 0;
+        uint32_t m_sample_count = 0;
+        uint32_t m_dimension = 0;
+    };
+} // namespace Karbon
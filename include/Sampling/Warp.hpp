@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Constants.hpp"
+#include "Tuples/Vector.hpp"
+
+namespace Karbon
+{
+    // Mappings from points of the unit square to directions. All of them are closed form, one 2D sample gives one
+    // direction with no rejection loop, and they are area preserving so stratified samples give stratified directions.
+
+    // maps a point of the unit square to a uniformly distributed unit vector
+    [[nodiscard]] inline Vector uniform_sphere(const float u, const float v) noexcept
+    {
+        const float z = 1.0f - 2.0f * u;
+        const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        const float phi = 2.0f * (float)std::numbers::pi * v;
+
+        return Vector(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    /**
+     * @brief Builds two unit vectors that form an orthonormal basis with the unit vector `n`
+     *
+     * Branchless construction of Duff et al. 2017 ("Building an Orthonormal Basis, Revisited"), stable for every n.
+     */
+    inline void orthonormal_basis(const Vector &n, Vector &tangent, Vector &bitangent) noexcept
+    {
+        const float sign = std::copysign(1.0f, n.z);
+        const float a = -1.0f / (sign + n.z);
+        const float b = n.x * n.y * a;
+
+        tangent = Vector(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+        bitangent = Vector(b, sign + n.y * n.y * a, -n.y);
+    }
+
+    // the direction (x, y, z) of the frame whose z axis is the unit vector `n`, in world space
+    [[nodiscard]] inline Vector from_local(const float x, const float y, const float z, const Vector &n) noexcept
+    {
+        Vector tangent, bitangent;
+        orthonormal_basis(n, tangent, bitangent);
+
+        return tangent * x + bitangent * y + n * z;
+    }
+
+    // Shirley-Chiu concentric mapping of the unit square to the unit disk, keeps neighbouring points together
+    inline void concentric_disk(const float u, const float v, float &x, float &y) noexcept
+    {
+        const float a = 2.0f * u - 1.0f;
+        const float b = 2.0f * v - 1.0f;
+
+        if (a == 0 && b == 0)
+        {
+            x = y = 0;
+            return;
+        }
+
+        constexpr float quarter_pi = (float)std::numbers::pi / 4.0f;
+
+        float r, phi;
+
+        if (std::abs(a) > std::abs(b))
+        {
+            r = a;
+            phi = quarter_pi * (b / a);
+        }
+        else
+        {
+            r = b;
+            phi = 2.0f * quarter_pi - quarter_pi * (a / b);
+        }
+
+        x = r * std::cos(phi);
+        y = r * std::sin(phi);
+    }
+
+    // a unit vector uniformly distributed over the hemisphere around the unit vector `n`, pdf 1 / (2 pi)
+    [[nodiscard]] inline Vector uniform_hemisphere(const float u, const float v, const Vector &n) noexcept
+    {
+        const float z = u;
+        const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        const float phi = 2.0f * (float)std::numbers::pi * v;
+
+        return from_local(r * std::cos(phi), r * std::sin(phi), z, n);
+    }
+
+    /**
+     * @brief A unit vector around the unit vector `n` distributed proportional to its cosine with n, pdf cos / pi
+     *
+     * Malley's method: a point of the unit disk projected up onto the hemisphere. This is the distribution of the
+     * Lambertian BRDF times the cosine term, so a diffuse bounce is weighted by its albedo alone.
+     */
+    [[nodiscard]] inline Vector cosine_hemisphere(const float u, const float v, const Vector &n) noexcept
+    {
+        float x, y;
+        concentric_disk(u, v, x, y);
+
+        return from_local(x, y, std::sqrt(std::max(0.0f, 1.0f - x * x - y * y)), n);
+    }
+} // namespace Karbon
@@ -40,9 +40,8 @@ namespace Karbon
             // get camera from json
             m_camera.from_json(json["camera"].dump());
 
-            // get world from json
-            m_world.from_json(json["world"].dump());
-            
+            // get world from json, meshes are found next to the scene file
+            m_world.from_json(json["world"].dump(), std::filesystem::path(file_name).parent_path().string());
         }
 
         World m_world;
@@ -20,7 +20,7 @@ namespace Karbon
 
         [[nodiscard]] Cube() = default;
 
-        [[nodiscard]] std::pair<float, Shape *> intersects(const Ray &ray) const
+        [[nodiscard]] std::pair<float, Shape *> intersects_local(const Ray &local_ray) const override
         {
             PROFILE_FUNCTION();
 
@@ -49,11 +49,9 @@ namespace Karbon
                 return std::make_pair(tmin, tmax);
             };
 
-            auto transformed_ray = ray.transform(get_inverse_transform());
-
-            auto xt = check_axis(transformed_ray.m_origin.x, transformed_ray.m_direction.x);
-            auto yt = check_axis(transformed_ray.m_origin.y, transformed_ray.m_direction.y);
-            auto zt = check_axis(transformed_ray.m_origin.z, transformed_ray.m_direction.z);
+            auto xt = check_axis(local_ray.m_origin.x, local_ray.m_direction.x);
+            auto yt = check_axis(local_ray.m_origin.y, local_ray.m_direction.y);
+            auto zt = check_axis(local_ray.m_origin.z, local_ray.m_direction.z);
 
             float tmin = std::max(xt.first, std::max(yt.first, zt.first));
             float tmax = std::min(xt.second, std::min(yt.second, zt.second));
@@ -81,6 +79,11 @@ namespace Karbon
             return Vector(0, 0, local_p.z);
         }
 
+        [[nodiscard]] AABB get_bounds() const override
+        {
+            return AABB(Point(-1, -1, -1), Point(1, 1, 1));
+        }
+
         // implement abstract equality
         [[nodiscard]] bool operator==(const Shape &other) const override
         {
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <Constants.hpp>
+#include <Materials/Dielectric.hpp>
+#include <Materials/Lambertian.hpp>
+#include <Materials/Material.hpp>
+#include <Materials/Metal.hpp>
+#include <ObjLoader.hpp>
+#include <Shapes/Cube.hpp>
+#include <Shapes/Instance.hpp>
+#include <Shapes/MeshGeometry.hpp>
+#include <Shapes/Shape.hpp>
+#include <Shapes/Sphere.hpp>
+#include <Shapes/TriangleMesh.hpp>
+
+namespace Karbon
+{
+    /**
+     * @brief The geometry of a World that can be shared: named prototypes for instances, and every loaded OBJ file
+     *
+     * A prototype is a Mesh, Sphere or Cube with the identity transform and a default material, declared once in the
+     * "geometries" object of a scene file and placed any number of times by "Instance" shapes. OBJ files are loaded
+     * once per path, so prototypes and plain "Mesh" shapes naming the same file share its triangles and BVH.
+     */
+    struct GeometryLibrary
+    {
+        [[nodiscard]] GeometryLibrary() = default;
+
+        void clear()
+        {
+            m_prototypes.clear();
+            m_meshes.clear();
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return m_prototypes.empty();
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return m_prototypes.size();
+        }
+
+        /**
+         * @brief Makes this library a copy of `other` for a World that is rendered while the original is edited
+         *
+         * The prototypes are new shapes with materials of their own, the triangles and BVHs of the meshes (loaded
+         * from files or not) stay shared, nothing is read from disk.
+         */
+        void copy_from(const GeometryLibrary &other)
+        {
+            m_meshes = other.m_meshes;
+            m_prototypes.clear();
+
+            for (const auto &[name, prototype] : other.m_prototypes)
+            {
+                std::shared_ptr<Shape> copy;
+
+                if (const auto mesh = dynamic_cast<const TriangleMesh *>(prototype.get()))
+                    copy = std::make_shared<TriangleMesh>(mesh->get_geometry(), mesh->get_file());
+                else if (dynamic_cast<const Sphere *>(prototype.get()))
+                    copy = std::make_shared<Sphere>();
+                else if (dynamic_cast<const Cube *>(prototype.get()))
+                    copy = std::make_shared<Cube>();
+                else
+                    continue; // add() only takes the kinds above
+
+                if (auto material = material_from_json(nlohmann::json::parse(prototype->get_material()->to_json())))
+                    copy->set_material(material);
+
+                add(name, copy);
+            }
+        }
+
+        /**
+         * @brief The triangles of an OBJ file, loaded on the first request for its path
+         *
+         * @param file The path as written in the scene file
+         * @param base_directory Relative paths are resolved against it
+         * @return std::shared_ptr<const MeshGeometry> nullptr if the file can't be loaded (and it is tried again
+         * the next time)
+         */
+        [[nodiscard]] std::shared_ptr<const MeshGeometry> load_mesh(const std::string &file, const std::string &base_directory)
+        {
+            const std::string path = ObjLoader::resolve(file, base_directory);
+
+            const auto it = m_meshes.find(path);
+
+            if (it != m_meshes.end())
+                return it->second;
+
+            std::shared_ptr<const MeshGeometry> mesh = ObjLoader::load(path);
+
+            if (mesh != nullptr)
+                m_meshes.emplace(path, mesh);
+
+            return mesh;
+        }
+
+        /**
+         * @brief Declares (or replaces) a prototype
+         *
+         * @param name The name instances refer to it by
+         * @param prototype A TriangleMesh, Sphere or Cube with the identity transform, its material is the default of
+         * its instances
+         * @return false for any other kind of shape, which the "geometries" of a scene file can't describe
+         */
+        bool add(const std::string &name, const std::shared_ptr<Shape> &prototype)
+        {
+            if (type_name(*prototype) == nullptr)
+            {
+                debug_print("[WORLD]: ", std::string("Unsupported geometry kind ") + prototype->get_name() + "for " + name);
+                return false;
+            }
+
+            m_prototypes[name] = prototype;
+
+            return true;
+        }
+
+        /**
+         * @brief Declares a prototype from its scene file entry
+         *
+         * @param name The key of the entry in "geometries"
+         * @param json {"type": "Mesh", "file": ...}, {"type": "Sphere"} or {"type": "Cube"}, with an optional "material"
+         * @param base_directory The directory of the scene file
+         * @return false if the type is unknown or the mesh can't be loaded
+         */
+        bool add_from_json(const std::string &name, const nlohmann::json &json, const std::string &base_directory)
+        {
+            std::shared_ptr<Shape> prototype;
+
+            if (json["type"] == "Mesh")
+            {
+                const std::string file = json["file"].get<std::string>();
+                auto mesh = load_mesh(file, base_directory);
+
+                if (mesh != nullptr)
+                    prototype = std::make_shared<TriangleMesh>(std::move(mesh), file);
+            }
+            else if (json["type"] == "Sphere")
+                prototype = std::make_shared<Sphere>();
+            else if (json["type"] == "Cube")
+                prototype = std::make_shared<Cube>();
+
+            if (prototype == nullptr)
+            {
+                debug_print("[WORLD]: ", "Can't create geometry " + name);
+                return false;
+            }
+
+            if (json.contains("material"))
+                if (auto material = material_from_json(json["material"]))
+                    prototype->set_material(material);
+
+            return add(name, prototype);
+        }
+
+        [[nodiscard]] std::shared_ptr<const Shape> find(const std::string &name) const
+        {
+            const auto it = m_prototypes.find(name);
+            return it != m_prototypes.end() ? it->second : nullptr;
+        }
+
+        // a new instance of prototype `name` at the origin, nullptr if there is no such prototype
+        [[nodiscard]] std::shared_ptr<Instance> instantiate(const std::string &name) const
+        {
+            auto prototype = find(name);
+
+            if (prototype == nullptr)
+                return nullptr;
+
+            return std::make_shared<Instance>(name, std::move(prototype));
+        }
+
+        /**
+         * @brief Deserializes an "Instance" shape
+         *
+         * @param json {"type": "Instance", "geometry": name, "translation", "rotation", "scale"} and an optional
+         * "material" that replaces the prototype's
+         * @return std::shared_ptr<Instance> nullptr if the geometry isn't declared
+         */
+        [[nodiscard]] std::shared_ptr<Instance> instance_from_json(const std::string &json) const
+        {
+            nlohmann::json j = nlohmann::json::parse(json);
+
+            auto instance = instantiate(j["geometry"].get<std::string>());
+
+            if (instance == nullptr)
+            {
+                debug_print("[WORLD]: ", "Unknown geometry " + j["geometry"].get<std::string>());
+                return nullptr;
+            }
+
+            Point translation = Point::from_json(j["translation"].dump());
+            Point scale = Point::from_json(j["scale"].dump());
+            Point rotation = Point::from_json(j["rotation"].dump());
+
+            float translationf[3] = {translation.x, translation.y, translation.z};
+            float scalef[3] = {scale.x, scale.y, scale.z};
+            float rotationf[3] = {rotation.x, rotation.y, rotation.z};
+
+            instance->transform(translationf, rotationf, scalef);
+
+            if (j.contains("material"))
+                if (auto material = material_from_json(j["material"]))
+                    instance->set_material(material);
+
+            return instance;
+        }
+
+        // the "geometries" object of a scene file
+        [[nodiscard]] nlohmann::json to_json() const
+        {
+            nlohmann::json json = nlohmann::json::object();
+
+            for (const auto &[name, prototype] : m_prototypes)
+            {
+                nlohmann::json entry;
+
+                entry["type"] = type_name(*prototype);
+
+                if (const auto mesh = dynamic_cast<const TriangleMesh *>(prototype.get()))
+                    entry["file"] = mesh->get_file();
+
+                entry["material"] = nlohmann::json::parse(prototype->get_material()->to_json());
+
+                json[name] = entry;
+            }
+
+            return json;
+        }
+
+        // bytes held by the triangles of the loaded meshes and mesh prototypes, each counted once however often it is used
+        [[nodiscard]] size_t memory_usage() const
+        {
+            std::unordered_set<const MeshGeometry *> meshes;
+
+            for (const auto &[path, mesh] : m_meshes)
+                meshes.insert(mesh.get());
+
+            for (const auto &[name, prototype] : m_prototypes)
+                if (const auto mesh = dynamic_cast<const TriangleMesh *>(prototype.get()))
+                    meshes.insert(mesh->get_geometry().get());
+
+            size_t bytes = 0;
+
+            for (const auto mesh : meshes)
+                bytes += mesh->memory_usage();
+
+            return bytes;
+        }
+
+    private:
+        // the "type" of a prototype in a scene file, nullptr for the kinds that can't be prototypes
+        [[nodiscard]] static const char *type_name(const Shape &shape)
+        {
+            if (dynamic_cast<const TriangleMesh *>(&shape))
+                return "Mesh";
+            if (dynamic_cast<const Sphere *>(&shape))
+                return "Sphere";
+            if (dynamic_cast<const Cube *>(&shape))
+                return "Cube";
+
+            return nullptr;
+        }
+
+        [[nodiscard]] static std::shared_ptr<Material> material_from_json(const nlohmann::json &json)
+        {
+            if (json["type"] == "Metal")
+                return Metal::from_json(json.dump());
+            if (json["type"] == "Lambertian")
+                return Lambertian::from_json(json.dump());
+            if (json["type"] == "Dielectric")
+                return Dielectric::from_json(json.dump());
+
+            return nullptr;
+        }
+
+        std::map<std::string, std::shared_ptr<Shape>> m_prototypes;                   // ordered, so scene files are written the same way every time
+        std::unordered_map<std::string, std::shared_ptr<const MeshGeometry>> m_meshes; // by resolved path
+    };
+} // namespace Karbon
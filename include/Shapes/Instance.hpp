@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Constants.hpp>
+#include <Materials/Material.hpp>
+#include <Matrix.hpp>
+#include <Ray.hpp>
+#include <Shapes/Shape.hpp>
+#include <Tuples/Point.hpp>
+#include <Tuples/Vector.hpp>
+
+namespace Karbon
+{
+    /**
+     * @brief A placement of a shared prototype shape: its own transform and material, the prototype's geometry
+     *
+     * The prototype (a mesh, sphere or cube from the World's GeometryLibrary) keeps the identity transform and is
+     * never copied, so a thousand instances of a mesh hold one set of triangles and one triangle BVH between them.
+     * The World BVH over the instances is the top level of a two-level hierarchy, the prototypes' own acceleration
+     * data (TriangleBVH for meshes) is the bottom level. Moving an instance only changes the top level.
+     *
+     * The instance is the Shape the World sees: hits, materials and normals are reported for it, the prototype only
+     * answers queries in object space.
+     */
+    struct Instance : public Shape
+    {
+        /**
+         * @param geometry Name of the prototype in the GeometryLibrary, written back by to_json
+         * @param prototype The shared shape, its transform has to be the identity
+         */
+        [[nodiscard]] Instance(std::string geometry, std::shared_ptr<const Shape> prototype)
+            : m_geometry(std::move(geometry)), m_prototype(std::move(prototype))
+        {
+            set_material(m_prototype->get_material());
+        }
+
+        [[nodiscard]] std::pair<float, Shape *> intersects_local(const Ray &local_ray) const override
+        {
+            auto xs = m_prototype->intersects_local(local_ray);
+
+            if (xs.second != nullptr)
+                xs.second = (Shape *)this;
+
+            return xs;
+        }
+
+        [[nodiscard]] bool closest_hit_local(const Ray &local_ray, const float t_min, Hit &hit) const override
+        {
+            if (!m_prototype->closest_hit_local(local_ray, t_min, hit))
+                return false;
+
+            hit.m_object = (Shape *)this;
+
+            return true;
+        }
+
+        [[nodiscard]] bool occluded_local(const Ray &local_ray, const float t_min, const float t_max) const override
+        {
+            return m_prototype->occluded_local(local_ray, t_min, t_max);
+        }
+
+        // the prototype's normal at the object space point is its object space normal, it isn't transformed
+        [[nodiscard]] Vector normal_at(const Point &p) const override
+        {
+            return (get_normal_transform() * m_prototype->normal_at(get_inverse_transform() * p)).normalize();
+        }
+
+        [[nodiscard]] Vector normal_at_primitive(const Point &p, const uint32_t primitive) const override
+        {
+            return (get_normal_transform() * m_prototype->normal_at_primitive(get_inverse_transform() * p, primitive)).normalize();
+        }
+
+        [[nodiscard]] AABB get_bounds() const override
+        {
+            return m_prototype->get_bounds();
+        }
+
+        [[nodiscard]] const std::string &get_geometry() const noexcept
+        {
+            return m_geometry;
+        }
+
+        [[nodiscard]] const std::shared_ptr<const Shape> &get_prototype() const noexcept
+        {
+            return m_prototype;
+        }
+
+        // false while the instance uses the material of its prototype
+        [[nodiscard]] bool has_material_override() const
+        {
+            return get_material() != m_prototype->get_material();
+        }
+
+        // implement abstract equality
+        [[nodiscard]] bool operator==(const Shape &other) const override
+        {
+            const auto other_instance = dynamic_cast<const Instance *>(&other);
+            return other_instance != nullptr && other_instance->m_prototype == m_prototype && other_instance->get_transform() == get_transform();
+        }
+
+        // get name
+        [[nodiscard]] const char *get_name() const override
+        {
+            return "Instance ";
+        }
+
+        // serialize all data to a nlohmann json string object, the material only if it overrides the prototype's
+        [[nodiscard]] std::string to_json() const noexcept
+        {
+            nlohmann::json j;
+
+            j["type"] = "Instance";
+            j["geometry"] = m_geometry;
+            j["translation"] = nlohmann::json::parse(get_translation().to_json());
+            j["scale"] = nlohmann::json::parse(get_scale().to_json());
+            j["rotation"] = nlohmann::json::parse(get_rotations().to_json());
+
+            if (has_material_override())
+                j["material"] = nlohmann::json::parse(get_material()->to_json());
+
+            return j.dump();
+        }
+
+    private:
+        std::string m_geometry;
+        std::shared_ptr<const Shape> m_prototype;
+    };
+}; // namespace Karbon
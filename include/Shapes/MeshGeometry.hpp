@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Acceleration/AABB.hpp"
+#include "Acceleration/TriangleBVH.hpp"
+#include "Constants.hpp"
+#include "Ray.hpp"
+#include "Tuples/Point.hpp"
+#include "Tuples/Vector.hpp"
+
+namespace Karbon
+{
+    /**
+     * @brief The triangles of a mesh in object space: one shared vertex buffer, three indices per triangle and a
+     * TriangleBVH over them
+     *
+     * Immutable once built, so any number of TriangleMesh shapes can share one through a shared_ptr.
+     */
+    struct MeshGeometry
+    {
+        [[nodiscard]] MeshGeometry() = default;
+
+        [[nodiscard]] MeshGeometry(std::vector<Point> positions, std::vector<uint32_t> indices)
+            : m_positions(std::move(positions)), m_indices(std::move(indices))
+        {
+            build();
+        }
+
+        // (re)builds the BVH, reorders the triangles
+        void build()
+        {
+            m_bvh.build(m_positions, m_indices);
+        }
+
+        [[nodiscard]] size_t triangle_count() const noexcept
+        {
+            return m_indices.size() / 3;
+        }
+
+        [[nodiscard]] size_t vertex_count() const noexcept
+        {
+            return m_positions.size();
+        }
+
+        [[nodiscard]] AABB get_bounds() const noexcept
+        {
+            return m_bvh.get_bounds();
+        }
+
+        // bytes held by the vertex, index and node buffers
+        [[nodiscard]] size_t memory_usage() const noexcept
+        {
+            return m_positions.size() * sizeof(Point) + m_indices.size() * sizeof(uint32_t) + m_bvh.get_nodes().size() * sizeof(BVHNode);
+        }
+
+        [[nodiscard]] const Point &vertex(const uint32_t triangle, const int corner) const noexcept
+        {
+            assert(triangle < triangle_count());
+            return m_positions[m_indices[3 * triangle + (uint32_t)corner]];
+        }
+
+        // unnormalized object space normal, counter-clockwise triangles face the viewer
+        [[nodiscard]] Vector normal(const uint32_t triangle) const noexcept
+        {
+            const Point &p0 = vertex(triangle, 0);
+            return (vertex(triangle, 1) - p0).cross(vertex(triangle, 2) - p0);
+        }
+
+        // see TriangleBVH::closest_hit
+        [[nodiscard]] bool closest_hit(const Ray &local_ray, const float t_min, float &t, uint32_t &triangle) const
+        {
+            return m_bvh.closest_hit(local_ray, m_positions, m_indices, t_min, t, triangle);
+        }
+
+        [[nodiscard]] bool occluded(const Ray &local_ray, const float t_min, const float t_max) const
+        {
+            return m_bvh.occluded(local_ray, m_positions, m_indices, t_min, t_max);
+        }
+
+        /**
+         * @brief The triangle closest to an object space point, for callers that only have the point
+         *
+         * Linear in the triangle count, intersections found through closest_hit know their triangle.
+         */
+        [[nodiscard]] uint32_t closest_triangle(const Point &p) const noexcept
+        {
+            uint32_t best = 0;
+            float best_distance = std::numeric_limits<float>::infinity();
+
+            for (uint32_t i = 0; i < (uint32_t)triangle_count(); i++)
+            {
+                const Vector n = normal(i);
+                const float length_squared = n.dot(n);
+
+                if (length_squared == 0)
+                    continue;
+
+                // distance to the plane of the triangle, good enough for a point that lies on the mesh
+                const float plane_distance = (p - vertex(i, 0)).dot(n);
+                const float distance = plane_distance * plane_distance / length_squared;
+
+                const AABB box = AABB().expand(vertex(i, 0)).expand(vertex(i, 1)).expand(vertex(i, 2));
+                const Point clamped(std::clamp(p.x, box.m_min.x, box.m_max.x), std::clamp(p.y, box.m_min.y, box.m_max.y), std::clamp(p.z, box.m_min.z, box.m_max.z));
+                const Vector outside = p - clamped;
+
+                if (distance + outside.dot(outside) < best_distance)
+                {
+                    best_distance = distance + outside.dot(outside);
+                    best = i;
+                }
+            }
+
+            return best;
+        }
+
+    private:
+        std::vector<Point> m_positions;
+        std::vector<uint32_t> m_indices; // three per triangle, in TriangleBVH order
+        TriangleBVH m_bvh;
+    };
+} // namespace Karbon
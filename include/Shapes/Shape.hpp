@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Acceleration/AABB.hpp"
+#include "Acceleration/Hit.hpp"
 #include "Constants.hpp"
 #include "Materials/Lambertian.hpp"
 #include "Materials/Material.hpp"
@@ -16,12 +18,71 @@ namespace Karbon
     struct Shape
     {
 
-        [[nodiscard]] virtual std::pair<float, Shape *> intersects(const Ray &ray) const = 0;
+        // intersects a ray that is already in object space, i.e. transformed by the inverse transform
+        [[nodiscard]] virtual std::pair<float, Shape *> intersects_local(const Ray &local_ray) const = 0;
+
+        [[nodiscard]] std::pair<float, Shape *> intersects(const Ray &ray) const
+        {
+            return intersects_local(ray.transform(m_inverse_transform));
+        }
+
+        /**
+         * @brief Nearest hit of a ray in object space inside (t_min, hit.m_t)
+         *
+         * Shapes made of many primitives (TriangleMesh) override it to stop searching beyond hit.m_t and to
+         * report which primitive was hit, the others only have the one intersects_local finds.
+         *
+         * @return true if the hit was updated
+         */
+        [[nodiscard]] virtual bool closest_hit_local(const Ray &local_ray, const float t_min, Hit &hit) const
+        {
+            const auto shape_xs = intersects_local(local_ray);
+
+            if (shape_xs.first > t_min && shape_xs.first < hit.m_t)
+            {
+                hit.m_t = shape_xs.first;
+                hit.m_object = shape_xs.second;
+                hit.m_primitive = 0;
+                return true;
+            }
+
+            return false;
+        }
+
+        // true if the ray in object space hits the shape inside (t_min, t_max), any hit will do
+        [[nodiscard]] virtual bool occluded_local(const Ray &local_ray, const float t_min, const float t_max) const
+        {
+            const float t = intersects_local(local_ray).first;
+            return t > t_min && t < t_max;
+        }
 
         virtual ~Shape() = default;
 
         [[nodiscard]] virtual Vector normal_at(const Point &p) const = 0;
 
+        // normal at a point of `primitive` (Hit::m_primitive), only shapes made of primitives need more than the point
+        [[nodiscard]] virtual Vector normal_at_primitive(const Point &p, [[maybe_unused]] const uint32_t primitive) const
+        {
+            return normal_at(p);
+        }
+
+        // object space bounding box, shapes that extend to infinity return an empty (invalid) box
+        [[nodiscard]] virtual AABB get_bounds() const
+        {
+            return AABB();
+        }
+
+        [[nodiscard]] bool is_bounded() const
+        {
+            return get_bounds().is_valid();
+        }
+
+        // bounding box of the shape after applying its transform
+        [[nodiscard]] AABB get_world_bounds() const
+        {
+            return get_bounds().transform(m_transform);
+        }
+
         // setters and getters
         [[nodiscard]] const std::shared_ptr<Material> &get_material() const
         {
@@ -33,11 +94,29 @@ namespace Karbon
             return m_material;
         }
 
+        // index of the material in the MaterialTable of the World the shape was last built into
+        [[nodiscard]] constexpr uint32_t get_material_index() const noexcept
+        {
+            return m_material_index;
+        }
+
+        constexpr Shape &set_material_index(const uint32_t index) noexcept
+        {
+            m_material_index = index;
+
+            return *this;
+        }
+
         [[nodiscard]] constexpr const Matrix4 &get_transform() const
         {
             return m_transform;
         }
 
+        [[nodiscard]] constexpr const AffineTransform &get_affine_transform() const
+        {
+            return m_affine_transform;
+        }
+
         [[nodiscard]] constexpr const Matrix4 &get_inverse_transform() const
         {
             return m_inverse_transform;
@@ -71,10 +150,7 @@ namespace Karbon
             m_rotation_z = rotation[2];
             m_scale = Vector(scale[0], scale[1], scale[2]);
 
-            m_transform = Karbon::IDENTITY.translate(translation[0], translation[1], translation[2]).scale(scale[0], scale[1], scale[2]);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(AffineTransform::translation(translation[0], translation[1], translation[2]) * AffineTransform::scaling(scale[0], scale[1], scale[2]));
 
             return *this;
         }
@@ -87,10 +163,7 @@ namespace Karbon
             m_rotation_z = rotation[2];
             m_scale = Vector(scale[0], scale[1], scale[2]);
 
-            m_transform = Karbon::IDENTITY.translate(translation[0], translation[1], translation[2]).scale(scale[0], scale[1], scale[2]).rotate(m_rotation_x, m_rotation_y, m_rotation_z);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(AffineTransform::compose(m_translation, get_rotations(), m_scale));
 
             return *this;
         }
@@ -103,10 +176,7 @@ namespace Karbon
             m_rotation_z = rotation[2] * (float)std::numbers::pi / 180.0f;
             m_scale = Vector(scale[0], scale[1], scale[2]);
 
-            m_transform = Karbon::IDENTITY.translate(translation[0], translation[1], translation[2]).scale(scale[0], scale[1], scale[2]).rotate(m_rotation_x, m_rotation_y, m_rotation_z);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(AffineTransform::compose(m_translation, get_rotations(), m_scale));
 
             return *this;
         }
@@ -115,10 +185,7 @@ namespace Karbon
         Shape &translate(const Vector &t)
         {
             m_translation = t;
-            m_transform = Karbon::IDENTITY.translate(t.x, t.y, t.z);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(AffineTransform::translation(t.x, t.y, t.z));
 
             return *this;
         }
@@ -127,10 +194,7 @@ namespace Karbon
         Shape &translate(const float x, const float y, const float z)
         {
             m_translation = Vector(x, y, z);
-            m_transform = Karbon::IDENTITY.translate(x, y, z);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(AffineTransform::translation(x, y, z));
 
             return *this;
         }
@@ -139,10 +203,7 @@ namespace Karbon
         Shape &scale(const Vector &s)
         {
             m_scale = s;
-            m_transform = m_transform.scale(s.x, s.y, s.z);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(m_affine_transform * AffineTransform::scaling(s.x, s.y, s.z));
 
             return *this;
         }
@@ -151,10 +212,7 @@ namespace Karbon
         Shape &scale(const float x, const float y, const float z)
         {
             m_scale = Vector(x, y, z);
-            m_transform = m_transform.scale(x, y, z);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(m_affine_transform * AffineTransform::scaling(x, y, z));
 
             return *this;
         }
@@ -163,10 +221,7 @@ namespace Karbon
         Shape &rotate_x(const float radians)
         {
             m_rotation_x = radians;
-            m_transform = m_transform.rotate_x(radians);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(m_affine_transform * AffineTransform::rotation_x(radians));
 
             return *this;
         }
@@ -174,10 +229,7 @@ namespace Karbon
         Shape &rotate_y(const float radians)
         {
             m_rotation_y = radians;
-            m_transform = m_transform.rotate_y(radians);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(m_affine_transform * AffineTransform::rotation_y(radians));
 
             return *this;
         }
@@ -185,10 +237,7 @@ namespace Karbon
         Shape &rotate_z(const float radians)
         {
             m_rotation_z = radians;
-            m_transform = m_transform.rotate_z(radians);
-            m_inverse_transform = m_transform.inverse();
-            m_normal_transform = m_inverse_transform.transpose();
-            m_inverse_normal_transform = m_normal_transform.inverse();
+            set_affine_transform(m_affine_transform * AffineTransform::rotation_z(radians));
 
             return *this;
         }
@@ -248,9 +297,23 @@ namespace Karbon
         [[nodiscard]] virtual std::string to_json() const noexcept = 0;
 
     private:
+        // the only place the transforms are written, one closed form affine inverse and two transposes
+        void set_affine_transform(const AffineTransform &transform)
+        {
+            m_affine_transform = transform;
+            m_transform = transform.to_matrix();
+            m_inverse_transform = transform.inverse().to_matrix();
+            m_normal_transform = m_inverse_transform.transpose();
+
+            // (M^-1)^T inverted is just M^T
+            m_inverse_normal_transform = m_transform.transpose();
+        }
+
         // private:
         std::shared_ptr<Material> m_material = std::make_shared<Lambertian>(Lambertian(Color(0.5f, 0.5f, 0.5f)));
+        uint32_t m_material_index = 0;
         // std::shared_ptr<Pattern> m_pattern = nullptr;
+        Karbon::AffineTransform m_affine_transform;
         Karbon::Matrix4 m_transform = Karbon::IDENTITY;
         Karbon::Matrix4 m_inverse_transform = Karbon::IDENTITY;
         Karbon::Matrix4 m_normal_transform = Karbon::IDENTITY;
@@ -21,16 +21,14 @@ namespace Karbon
 
         [[nodiscard]] Sphere() = default;
 
-        [[nodiscard]] std::pair<float, Shape *> intersects(const Ray &ray) const
+        [[nodiscard]] std::pair<float, Shape *> intersects_local(const Ray &local_ray) const override
         {
             PROFILE_FUNCTION();
 
-            Ray transformed_ray = ray.transform(get_inverse_transform());
+            Vector sphere_to_ray = local_ray.m_origin - Point();
 
-            Vector sphere_to_ray = transformed_ray.m_origin - Point();
-
-            float a = transformed_ray.m_direction.dot(transformed_ray.m_direction);
-            float b = 2 * sphere_to_ray.dot(transformed_ray.m_direction);
+            float a = local_ray.m_direction.dot(local_ray.m_direction);
+            float b = 2 * sphere_to_ray.dot(local_ray.m_direction);
             float c = sphere_to_ray.dot(sphere_to_ray) - 1;
 
             float discriminant = b * b - 4 * a * c;
@@ -65,6 +63,11 @@ namespace Karbon
             return (get_normal_transform() * object_normal).normalize();
         }
 
+        [[nodiscard]] AABB get_bounds() const override
+        {
+            return AABB(Point(-1, -1, -1), Point(1, 1, 1));
+        }
+
         // implement abstract equality
         [[nodiscard]] bool operator==(const Shape &other) const override
         {
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <Constants.hpp>
+#include <Materials/Dielectric.hpp>
+#include <Materials/Lambertian.hpp>
+#include <Materials/Material.hpp>
+#include <Materials/Metal.hpp>
+#include <Matrix.hpp>
+#include <ObjLoader.hpp>
+#include <Ray.hpp>
+#include <Shapes/MeshGeometry.hpp>
+#include <Shapes/Shape.hpp>
+#include <Tuples/Point.hpp>
+#include <Tuples/Vector.hpp>
+
+namespace Karbon
+{
+    /**
+     * @brief A triangle mesh placed in the world by the usual Shape transform
+     *
+     * The triangles live in a MeshGeometry (shared vertex and index buffers plus a TriangleBVH), the World BVH sees
+     * the mesh as one shape and descends into the triangle BVH from closest_hit_local. Hits report the triangle as
+     * Hit::m_primitive so the normal is found without searching.
+     */
+    struct TriangleMesh : public Shape
+    {
+        [[nodiscard]] TriangleMesh() = default;
+
+        [[nodiscard]] explicit TriangleMesh(std::shared_ptr<const MeshGeometry> geometry, std::string file = "")
+            : m_geometry(std::move(geometry)), m_file(std::move(file))
+        {
+        }
+
+        [[nodiscard]] std::pair<float, Shape *> intersects_local(const Ray &local_ray) const override
+        {
+            PROFILE_FUNCTION();
+
+            float t = std::numeric_limits<float>::infinity();
+            uint32_t triangle = 0;
+
+            if (m_geometry == nullptr || !m_geometry->closest_hit(local_ray, 0, t, triangle))
+                return {};
+
+            return {t, (Shape *)this};
+        }
+
+        [[nodiscard]] bool closest_hit_local(const Ray &local_ray, const float t_min, Hit &hit) const override
+        {
+            float t = hit.m_t;
+            uint32_t triangle = 0;
+
+            if (m_geometry == nullptr || !m_geometry->closest_hit(local_ray, t_min, t, triangle))
+                return false;
+
+            hit.m_t = t;
+            hit.m_object = (Shape *)this;
+            hit.m_primitive = triangle;
+
+            return true;
+        }
+
+        [[nodiscard]] bool occluded_local(const Ray &local_ray, const float t_min, const float t_max) const override
+        {
+            return m_geometry != nullptr && m_geometry->occluded(local_ray, t_min, t_max);
+        }
+
+        // only the point, the triangle has to be searched for
+        [[nodiscard]] Vector normal_at(const Point &p) const override
+        {
+            PROFILE_FUNCTION();
+
+            if (m_geometry == nullptr)
+                return Vector(0, 1, 0);
+
+            return normal_at_primitive(p, m_geometry->closest_triangle(get_inverse_transform() * p));
+        }
+
+        [[nodiscard]] Vector normal_at_primitive([[maybe_unused]] const Point &p, const uint32_t primitive) const override
+        {
+            return (get_normal_transform() * m_geometry->normal(primitive)).normalize();
+        }
+
+        [[nodiscard]] AABB get_bounds() const override
+        {
+            return m_geometry != nullptr ? m_geometry->get_bounds() : AABB();
+        }
+
+        [[nodiscard]] const std::shared_ptr<const MeshGeometry> &get_geometry() const noexcept
+        {
+            return m_geometry;
+        }
+
+        // the path the mesh was loaded from, as written in the scene file
+        [[nodiscard]] const std::string &get_file() const noexcept
+        {
+            return m_file;
+        }
+
+        // implement abstract equality
+        [[nodiscard]] bool operator==(const Shape &other) const override
+        {
+            const auto other_mesh = dynamic_cast<const TriangleMesh *>(&other);
+            return other_mesh != nullptr && other_mesh->m_geometry == m_geometry && other_mesh->get_transform() == get_transform();
+        }
+
+        // get name
+        [[nodiscard]] const char *get_name() const override
+        {
+            return "Mesh ";
+        }
+
+        // serialize all data to a nlohmann json string object, the triangles stay in the file
+        [[nodiscard]] std::string to_json() const noexcept
+        {
+            nlohmann::json j;
+
+            j["type"] = "Mesh";
+            j["file"] = m_file;
+            j["translation"] = nlohmann::json::parse(get_translation().to_json());
+            j["scale"] = nlohmann::json::parse(get_scale().to_json());
+            j["rotation"] = nlohmann::json::parse(get_rotations().to_json());
+            j["material"] = nlohmann::json::parse(get_material()->to_json());
+
+            return j.dump();
+        }
+
+        /**
+         * @brief Deserializes a mesh and loads the OBJ file it references
+         *
+         * @param json The shape object, "file" is the path of the .obj file
+         * @param base_directory Relative paths are resolved against it, the directory of the scene file
+         * @return std::shared_ptr<TriangleMesh> nullptr if the file can't be loaded
+         */
+        static std::shared_ptr<TriangleMesh> from_json(const std::string &json, const std::string &base_directory = "") noexcept
+        {
+            nlohmann::json j = nlohmann::json::parse(json);
+
+            auto geometry = ObjLoader::load(ObjLoader::resolve(j["file"].get<std::string>(), base_directory));
+
+            if (geometry == nullptr)
+                return nullptr;
+
+            return from_json(json, std::move(geometry));
+        }
+
+        // deserializes a mesh whose file was already loaded (by the GeometryLibrary, which loads every file once)
+        static std::shared_ptr<TriangleMesh> from_json(const std::string &json, std::shared_ptr<const MeshGeometry> geometry) noexcept
+        {
+            nlohmann::json j = nlohmann::json::parse(json);
+
+            auto mesh = std::make_shared<TriangleMesh>(std::move(geometry), j["file"].get<std::string>());
+
+            Point translation = Point::from_json(j["translation"].dump());
+            Point scale = Point::from_json(j["scale"].dump());
+            Point rotation = Point::from_json(j["rotation"].dump());
+
+            float translationf[3] = {translation.x, translation.y, translation.z};
+            float scalef[3] = {scale.x, scale.y, scale.z};
+            float rotationf[3] = {rotation.x, rotation.y, rotation.z};
+
+            mesh->transform(translationf, rotationf, scalef);
+
+            if (j["material"]["type"] == "Metal")
+                mesh->set_material(Metal::from_json(j["material"].dump()));
+            else if (j["material"]["type"] == "Lambertian")
+                mesh->set_material(Lambertian::from_json(j["material"].dump()));
+            else if (j["material"]["type"] == "Dielectric")
+                mesh->set_material(Dielectric::from_json(j["material"].dump()));
+
+            return mesh;
+        }
+
+    private:
+        std::shared_ptr<const MeshGeometry> m_geometry;
+        std::string m_file;
+    };
+}; // namespace Karbon
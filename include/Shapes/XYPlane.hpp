@@ -18,18 +18,16 @@ namespace Karbon
     {
         [[nodiscard]] XYPlane() = default;
 
-        [[nodiscard]] std::pair<float, Shape *> intersects(const Ray &ray) const
+        [[nodiscard]] std::pair<float, Shape *> intersects_local(const Ray &local_ray) const override
         {
             PROFILE_FUNCTION();
 
-            Ray transformed_ray = ray.transform(get_inverse_transform());
-
-            if (std::abs(transformed_ray.m_direction.z) < kEpsilon)
+            if (std::abs(local_ray.m_direction.z) < kEpsilon)
             {
                 return {};
             }
 
-            float t = -(transformed_ray.m_origin.z) / (transformed_ray.m_direction.z);
+            float t = -(local_ray.m_origin.z) / (local_ray.m_direction.z);
 
             if (t < 0)
             {
@@ -18,18 +18,16 @@ namespace Karbon
     {
         [[nodiscard]] XZPlane() = default;
 
-        [[nodiscard]] std::pair<float, Shape *> intersects(const Ray &ray) const
+        [[nodiscard]] std::pair<float, Shape *> intersects_local(const Ray &local_ray) const override
         {
             PROFILE_FUNCTION();
 
-            Ray transformed_ray = ray.transform(get_inverse_transform());
-
-            if (std::abs(transformed_ray.m_direction.y) < kEpsilon)
+            if (std::abs(local_ray.m_direction.y) < kEpsilon)
             {
                 return {};
             }
 
-            float t = -(transformed_ray.m_origin.y) / (transformed_ray.m_direction.y);
+            float t = -(local_ray.m_origin.y) / (local_ray.m_direction.y);
 
             if (t < 0)
             {
@@ -18,18 +18,16 @@ namespace Karbon
     {
         [[nodiscard]] YZPlane() = default;
 
-        [[nodiscard]] std::pair<float, Shape *> intersects(const Ray &ray) const
+        [[nodiscard]] std::pair<float, Shape *> intersects_local(const Ray &local_ray) const override
         {
             PROFILE_FUNCTION();
 
-            Ray transformed_ray = ray.transform(get_inverse_transform());
-
-            if (std::abs(transformed_ray.m_direction.x) < kEpsilon)
+            if (std::abs(local_ray.m_direction.x) < kEpsilon)
             {
                 return {};
             }
 
-            float t = -(transformed_ray.m_origin.x) / (transformed_ray.m_direction.x);
+            float t = -(local_ray.m_origin.x) / (local_ray.m_direction.x);
 
             if (t < 0)
             {
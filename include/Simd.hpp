@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// SIMD feature detection, every kernel using these has a scalar fallback
+// AVX needs to be enabled explicitly (-DKARBON_ENABLE_AVX2=ON), SSE2 is always there on x86-64
+
+#if defined(__AVX__)
+#define KARBON_SIMD_AVX 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KARBON_SIMD_SSE 1
+#endif
+
+#if defined(KARBON_SIMD_AVX) || defined(KARBON_SIMD_SSE)
+#include <immintrin.h>
+#endif
+
+namespace Karbon::simd
+{
+    /**
+     * @brief kWidth floats processed by one instruction, the widest the build allows
+     *
+     * Kernels written against FloatLanes/MaskLanes compile to AVX (8 lanes), SSE (4 lanes) or plain floats (1 lane).
+     * Only the handful of operations the intersection kernels need is provided.
+     */
+#if defined(KARBON_SIMD_AVX)
+
+    inline constexpr uint32_t kWidth = 8;
+
+    struct MaskLanes
+    {
+        __m256 m_value;
+
+        [[nodiscard]] friend MaskLanes operator&(const MaskLanes a, const MaskLanes b) noexcept { return {_mm256_and_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend MaskLanes operator|(const MaskLanes a, const MaskLanes b) noexcept { return {_mm256_or_ps(a.m_value, b.m_value)}; }
+
+        // one bit per lane, lane 0 is the lowest bit
+        [[nodiscard]] uint32_t bits() const noexcept { return (uint32_t)_mm256_movemask_ps(m_value); }
+    };
+
+    struct FloatLanes
+    {
+        __m256 m_value;
+
+        [[nodiscard]] static FloatLanes broadcast(const float value) noexcept { return {_mm256_set1_ps(value)}; }
+        [[nodiscard]] static FloatLanes load(const float *values) noexcept { return {_mm256_loadu_ps(values)}; }
+        void store(float *values) const noexcept { _mm256_storeu_ps(values, m_value); }
+
+        [[nodiscard]] friend FloatLanes operator+(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_add_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend FloatLanes operator-(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_sub_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend FloatLanes operator*(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_mul_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend FloatLanes operator/(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_div_ps(a.m_value, b.m_value)}; }
+
+        [[nodiscard]] friend MaskLanes operator<(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_cmp_ps(a.m_value, b.m_value, _CMP_LT_OQ)}; }
+        [[nodiscard]] friend MaskLanes operator>(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_cmp_ps(a.m_value, b.m_value, _CMP_GT_OQ)}; }
+        [[nodiscard]] friend MaskLanes operator<=(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_cmp_ps(a.m_value, b.m_value, _CMP_LE_OQ)}; }
+        [[nodiscard]] friend MaskLanes operator>=(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_cmp_ps(a.m_value, b.m_value, _CMP_GE_OQ)}; }
+    };
+
+    [[nodiscard]] inline FloatLanes min(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_min_ps(a.m_value, b.m_value)}; }
+    [[nodiscard]] inline FloatLanes max(const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_max_ps(a.m_value, b.m_value)}; }
+    [[nodiscard]] inline FloatLanes sqrt(const FloatLanes a) noexcept { return {_mm256_sqrt_ps(a.m_value)}; }
+    [[nodiscard]] inline FloatLanes abs(const FloatLanes a) noexcept { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.m_value)}; }
+
+    // lanes of `a` where the mask is set, lanes of `b` elsewhere
+    [[nodiscard]] inline FloatLanes select(const MaskLanes mask, const FloatLanes a, const FloatLanes b) noexcept { return {_mm256_blendv_ps(b.m_value, a.m_value, mask.m_value)}; }
+
+#elif defined(KARBON_SIMD_SSE)
+
+    inline constexpr uint32_t kWidth = 4;
+
+    struct MaskLanes
+    {
+        __m128 m_value;
+
+        [[nodiscard]] friend MaskLanes operator&(const MaskLanes a, const MaskLanes b) noexcept { return {_mm_and_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend MaskLanes operator|(const MaskLanes a, const MaskLanes b) noexcept { return {_mm_or_ps(a.m_value, b.m_value)}; }
+
+        // one bit per lane, lane 0 is the lowest bit
+        [[nodiscard]] uint32_t bits() const noexcept { return (uint32_t)_mm_movemask_ps(m_value); }
+    };
+
+    struct FloatLanes
+    {
+        __m128 m_value;
+
+        [[nodiscard]] static FloatLanes broadcast(const float value) noexcept { return {_mm_set1_ps(value)}; }
+        [[nodiscard]] static FloatLanes load(const float *values) noexcept { return {_mm_loadu_ps(values)}; }
+        void store(float *values) const noexcept { _mm_storeu_ps(values, m_value); }
+
+        [[nodiscard]] friend FloatLanes operator+(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_add_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend FloatLanes operator-(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_sub_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend FloatLanes operator*(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_mul_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend FloatLanes operator/(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_div_ps(a.m_value, b.m_value)}; }
+
+        [[nodiscard]] friend MaskLanes operator<(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_cmplt_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend MaskLanes operator>(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_cmpgt_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend MaskLanes operator<=(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_cmple_ps(a.m_value, b.m_value)}; }
+        [[nodiscard]] friend MaskLanes operator>=(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_cmpge_ps(a.m_value, b.m_value)}; }
+    };
+
+    [[nodiscard]] inline FloatLanes min(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_min_ps(a.m_value, b.m_value)}; }
+    [[nodiscard]] inline FloatLanes max(const FloatLanes a, const FloatLanes b) noexcept { return {_mm_max_ps(a.m_value, b.m_value)}; }
+    [[nodiscard]] inline FloatLanes sqrt(const FloatLanes a) noexcept { return {_mm_sqrt_ps(a.m_value)}; }
+    [[nodiscard]] inline FloatLanes abs(const FloatLanes a) noexcept { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.m_value)}; }
+
+    // lanes of `a` where the mask is set, lanes of `b` elsewhere (SSE2 has no blend)
+    [[nodiscard]] inline FloatLanes select(const MaskLanes mask, const FloatLanes a, const FloatLanes b) noexcept { return {_mm_or_ps(_mm_and_ps(mask.m_value, a.m_value), _mm_andnot_ps(mask.m_value, b.m_value))}; }
+
+#else
+
+    inline constexpr uint32_t kWidth = 1;
+
+    struct MaskLanes
+    {
+        bool m_value;
+
+        [[nodiscard]] friend MaskLanes operator&(const MaskLanes a, const MaskLanes b) noexcept { return {a.m_value && b.m_value}; }
+        [[nodiscard]] friend MaskLanes operator|(const MaskLanes a, const MaskLanes b) noexcept { return {a.m_value || b.m_value}; }
+
+        // one bit per lane, lane 0 is the lowest bit
+        [[nodiscard]] uint32_t bits() const noexcept { return m_value ? 1u : 0u; }
+    };
+
+    struct FloatLanes
+    {
+        float m_value;
+
+        [[nodiscard]] static FloatLanes broadcast(const float value) noexcept { return {value}; }
+        [[nodiscard]] static FloatLanes load(const float *values) noexcept { return {*values}; }
+        void store(float *values) const noexcept { *values = m_value; }
+
+        [[nodiscard]] friend FloatLanes operator+(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value + b.m_value}; }
+        [[nodiscard]] friend FloatLanes operator-(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value - b.m_value}; }
+        [[nodiscard]] friend FloatLanes operator*(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value * b.m_value}; }
+        [[nodiscard]] friend FloatLanes operator/(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value / b.m_value}; }
+
+        [[nodiscard]] friend MaskLanes operator<(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value < b.m_value}; }
+        [[nodiscard]] friend MaskLanes operator>(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value > b.m_value}; }
+        [[nodiscard]] friend MaskLanes operator<=(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value <= b.m_value}; }
+        [[nodiscard]] friend MaskLanes operator>=(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value >= b.m_value}; }
+    };
+
+    [[nodiscard]] inline FloatLanes min(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value < b.m_value ? a.m_value : b.m_value}; }
+    [[nodiscard]] inline FloatLanes max(const FloatLanes a, const FloatLanes b) noexcept { return {a.m_value > b.m_value ? a.m_value : b.m_value}; }
+    [[nodiscard]] inline FloatLanes sqrt(const FloatLanes a) noexcept { return {std::sqrt(a.m_value)}; }
+    [[nodiscard]] inline FloatLanes abs(const FloatLanes a) noexcept { return {std::abs(a.m_value)}; }
+
+    // lanes of `a` where the mask is set, lanes of `b` elsewhere
+    [[nodiscard]] inline FloatLanes select(const MaskLanes mask, const FloatLanes a, const FloatLanes b) noexcept { return {mask.m_value ? a.m_value : b.m_value}; }
+
+#endif
+
+    // mask with only the first `count` lanes set
+    [[nodiscard]] inline uint32_t first_lanes(const uint32_t count) noexcept
+    {
+        return count >= 32 ? ~0u : (1u << count) - 1u;
+    }
+} // namespace Karbon::simd
@@ -19,10 +19,14 @@ namespace Karbon
             return Vector(random(min, max), random(min, max), random(min, max));
         }
 
+        // a uniformly distributed unit vector (normalized cube points would crowd towards the corners)
         [[nodiscard]] static Vector random_in_unit_sphere()
         {
-            Vector p = make_random(-1, 1);
-            return p.normalize();
+            const float z = random<float>(-1, 1);
+            const float phi = random<float>(0, 2 * (float)std::numbers::pi);
+            const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+
+            return Vector(r * std::cos(phi), r * std::sin(phi), z);
         }
 
         [[nodiscard]] int operator==(const Vector &rhs) const noexcept
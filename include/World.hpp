@@ -1,20 +1,37 @@
 #pragma once
 
+#include "Acceleration/BVH.hpp"
+#include "Acceleration/Hit.hpp"
+#include "Acceleration/ShapeBatch.hpp"
 #include "Computation.hpp"
 #include "Constants.hpp"
 #include "Intersection.hpp"
 #include "Lights/Light.hpp"
+#include "Lights/LightTree.hpp"
 #include "Lights/PointLight.hpp"
+#include "Materials/MaterialTable.hpp"
 #include "Materials/Metal.hpp"
 #include "Matrix.hpp"
+#include "Sampling/Adaptive.hpp"
+#include "Sampling/Sampler.hpp"
+#include "Shapes/GeometryLibrary.hpp"
+#include "Shapes/Instance.hpp"
 #include "Shapes/Shape.hpp"
 #include "Shapes/Sphere.hpp"
+#include "Shapes/TriangleMesh.hpp"
 #include "Tuples/Color.hpp"
 #include "Tuples/Point.hpp"
 #include "Tuples/Vector.hpp"
 
 namespace Karbon
 {
+    // how the World keeps its bounded shapes for traversal
+    enum class ShapeStorage
+    {
+        BVH,    // every bounded shape in the BVH
+        Packed, // spheres and cubes in SphereBatch/CubeBatch tested kWidth at a time, anything else in the BVH
+    };
+
     struct World
     {
 
@@ -52,7 +69,11 @@ namespace Karbon
 
             std::vector<std::pair<float, Shape *>> res;
 
-            for (const auto &shape : m_shapes)
+            m_bvh.intersects(ray, res);
+            m_spheres.intersects(ray, res);
+            m_cubes.intersects(ray, res);
+
+            for (const auto &shape : m_unbounded_shapes)
             {
                 auto shape_xs = shape->intersects(ray);
                 if (shape_xs.first > 0)
@@ -66,56 +87,461 @@ namespace Karbon
             return res;
         }
 
-        [[nodiscard]] Color color_at(const Ray &ray, const int recurtion_level = 0) const
+        /**
+         * @brief Finds the nearest shape hit by the ray inside (t_min, t_max) without allocating
+         *
+         * @param ray The ray in world space
+         * @param t_min Lower bound of the interval
+         * @param t_max Upper bound of the interval
+         * @return Hit The nearest hit, invalid if nothing was hit
+         */
+        [[nodiscard]] Hit closest_hit(const Ray &ray, const float t_min = 0, const float t_max = std::numeric_limits<float>::infinity()) const
+        {
+            PROFILE_FUNCTION();
+
+            RayCounter::add();
+
+            Hit hit;
+            hit.m_t = t_max;
+
+            m_bvh.closest_hit(ray, t_min, hit);
+            m_spheres.closest_hit(ray, t_min, hit);
+            m_cubes.closest_hit(ray, t_min, hit);
+
+            for (const auto &shape : m_unbounded_shapes)
+            {
+                auto shape_xs = shape->intersects(ray);
+
+                if (shape_xs.first > t_min && shape_xs.first < hit.m_t)
+                {
+                    hit.m_t = shape_xs.first;
+                    hit.m_object = shape_xs.second;
+                    hit.m_primitive = 0;
+                }
+            }
+
+            return hit;
+        }
+
+        /**
+         * @brief True if any shape lies inside (0, t_max) along the ray, for shadow and visibility rays
+         *
+         * Returns at the first hit found instead of searching for the nearest one, and builds no hit record.
+         *
+         * @param ray The ray in world space
+         * @param t_max Upper bound of the interval, the distance to the light for a normalized shadow ray
+         * @return true if the ray is blocked before t_max
+         */
+        [[nodiscard]] bool occluded(const Ray &ray, const float t_max = std::numeric_limits<float>::infinity()) const
+        {
+            PROFILE_FUNCTION();
+
+            RayCounter::add();
+
+            if (m_bvh.occluded(ray, 0, t_max) || m_spheres.occluded(ray, 0, t_max) || m_cubes.occluded(ray, 0, t_max))
+                return true;
+
+            // unbounded shapes last, a shadow ray leaving a surface rarely ends on a plane (floors and walls face the lights)
+            for (const auto &shape : m_unbounded_shapes)
+            {
+                const float t = shape->intersects(ray).first;
+
+                if (t > 0 && t < t_max)
+                    return true;
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Which rays of a packet (shadow rays towards one light) are blocked before their m_t_max
+         *
+         * The BVH is traversed once for the whole packet, the rays it doesn't block are tested against the packed
+         * shapes and the unbounded ones one by one, in the same order as occluded(ray, t_max).
+         *
+         * @param packet The rays in world space, m_t_max is the distance to the light of each ray
+         * @return uint32_t The rays of packet.m_active that are blocked
+         */
+        [[nodiscard]] uint32_t occluded(const RayPacket &packet) const
+        {
+            PROFILE_FUNCTION();
+
+            RayCounter::add(packet.count());
+
+            uint32_t blocked = m_bvh.occluded(packet, 0);
+
+            for (uint32_t rays = packet.m_active & ~blocked; rays != 0; rays &= rays - 1)
+            {
+                const uint32_t ray = (uint32_t)std::countr_zero(rays);
+                const float t_max = packet.m_t_max[ray];
+
+                if (m_spheres.occluded(packet.m_rays[ray], 0, t_max) || m_cubes.occluded(packet.m_rays[ray], 0, t_max))
+                {
+                    blocked |= 1u << ray;
+                    continue;
+                }
+
+                for (const auto &shape : m_unbounded_shapes)
+                {
+                    const float t = shape->intersects(packet.m_rays[ray]).first;
+
+                    if (t > 0 && t < t_max)
+                    {
+                        blocked |= 1u << ray;
+                        break;
+                    }
+                }
+            }
+
+            return blocked;
+        }
+
+        /**
+         * @brief Closest hits of a packet of coherent rays (camera rays of a pixel block, shadow rays to one light)
+         *
+         * The BVH is traversed once for the whole packet, the packed shapes and the unbounded ones are tested shape
+         * by shape for every active ray.
+         *
+         * @param packet The rays in world space, each with its own upper bound
+         * @param hits The nearest hit of every ray, invalid where nothing was hit
+         * @param t_min Lower bound of the interval
+         */
+        void closest_hit(const RayPacket &packet, PacketHits &hits, const float t_min = 0) const
         {
-            auto xs = intersects(ray);
-            std::pair<float, Shape *> hit = Intersection::hit(xs);
+            PROFILE_FUNCTION();
+
+            RayCounter::add(packet.count());
+
+            hits.reset(packet);
+
+            m_bvh.closest_hit(packet, t_min, hits);
+
+            for (uint32_t rays = packet.m_active; rays != 0; rays &= rays - 1)
+            {
+                const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                Hit hit = hits[ray];
+
+                bool found = m_spheres.closest_hit(packet.m_rays[ray], t_min, hit);
+                found |= m_cubes.closest_hit(packet.m_rays[ray], t_min, hit);
 
+                if (found)
+                    hits.update(ray, hit.m_t, hit.m_object, hit.m_primitive);
+            }
+
+            for (const auto &shape : m_unbounded_shapes)
+            {
+                for (uint32_t rays = packet.m_active; rays != 0; rays &= rays - 1)
+                {
+                    const uint32_t ray = (uint32_t)std::countr_zero(rays);
+
+                    auto shape_xs = shape->intersects(packet.m_rays[ray]);
+
+                    if (shape_xs.first > t_min && shape_xs.first < hits.m_t[ray])
+                        hits.update(ray, shape_xs.first, shape_xs.second);
+                }
+            }
+        }
+
+        /**
+         * @brief Traces a path starting with `ray` and returns the light it gathers
+         *
+         * Iterative: the path throughput and radiance live in locals instead of one stack frame per bounce.
+         * A path ends when it misses (picking up the sky), when a material absorbs it, when it exceeds
+         * max_recurtion_level or the depth limit of the material class it hits, or by russian roulette once
+         * it is deeper than the roulette depth.
+         *
+         * @param ray The camera ray in world space
+         * @param sampler The sample values of this path, every random decision along the path reads them
+         * @param recurtion_level Bounce count the path starts at
+         * @return Color
+         */
+        [[nodiscard]] Color color_at(const Ray &ray, Sampler &sampler, const int recurtion_level = 0) const
+        {
             // If we've exceeded the ray bounce limit, no more light is gathered.
             if (recurtion_level > max_recurtion_level)
                 return Karbon::BLACK;
 
-            if (hit.first > 0)
+            return color_at(ray, closest_hit(ray), sampler, recurtion_level);
+        }
+
+        /**
+         * @brief Same as color_at(ray, sampler, recurtion_level) for a ray whose first hit is already known
+         *
+         * Used after tracing camera rays as a packet, every path continues on its own from the first scatter.
+         *
+         * @param ray The camera ray in world space
+         * @param first_hit closest_hit(ray)
+         * @param sampler The sample values of this path
+         * @param recurtion_level Bounce count the path starts at
+         * @return Color
+         */
+        [[nodiscard]] Color color_at(const Ray &ray, const Hit &first_hit, Sampler &sampler, const int recurtion_level = 0) const
+        {
+            Ray current = ray;
+            Color throughput = Karbon::WHITE;
+            Color radiance;
+            Hit hit = first_hit;
+
+            for (int depth = recurtion_level; depth <= max_recurtion_level; depth++)
             {
-                Intersection isect = Intersection(hit.first, *hit.second);
+                if (depth != recurtion_level)
+                    hit = closest_hit(current);
+
+                if (!hit.is_valid())
+                {
+                    radiance += throughput * sky_color(current);
+                    return radiance;
+                }
+
+                if (!continue_path(hit, depth, current, throughput, radiance, sampler))
+                    return radiance;
+            }
 
-                auto comp = isect.prepare_computation(ray, xs);
+            // If we've exceeded the ray bounce limit, no more light is gathered.
+            return radiance;
+        }
 
-                Ray scattered;
-                Color attenuation;
+        /**
+         * @brief One bounce of a path: samples the lights, scatters `ray` off the material it hit and updates the path throughput
+         *
+         * Applies the depth limit of the material class and russian roulette, shared by color_at and the
+         * wavefront renderer so both produce the same paths.
+         *
+         * @param hit closest_hit(ray), has to be valid
+         * @param depth Bounce count of the path
+         * @param ray In: the ray that hit. Out: the scattered ray
+         * @param throughput Attenuation gathered along the path so far
+         * @param radiance Light gathered by the path so far, the direct light of this bounce is added to it
+         * @param sampler The sample values of the path, positioned at the dimensions of this bounce
+         * @return false if the path ends here without picking up any more light
+         */
+        [[nodiscard]] bool continue_path(const Hit &hit, const int depth, Ray &ray, Color &throughput, Color &radiance, Sampler &sampler) const
+        {
+            const uint32_t material = hit.m_object->get_material_index();
 
-                if (hit.second->get_material()->scatter(comp, attenuation, scattered))
-                    return attenuation * color_at(scattered, recurtion_level + 1);
+            // this material class may not scatter any further
+            if (depth >= get_max_depth(m_materials.get_kind(material)))
+                return false;
 
-                return Karbon::BLACK;
+            Intersection isect = Intersection(hit.m_t, *hit.m_object, hit.m_primitive);
+
+            // only refraction needs the sorted list of every hit to figure out n1/n2
+            auto comp = m_materials.is_refractive(material) ? isect.prepare_computation(ray, intersects(ray)) : isect.prepare_computation(ray);
+
+            // next event estimation, a specular bounce can't see a point light so it only picks up light by scattering
+            if (!m_lights.empty() && !m_materials.is_specular(material))
+            {
+                sampler.start_bounce(depth, Sampler::kLightDimension);
+
+                // *= doesn't clamp to 255, a strong light may go past it before the throughput scales it down
+                Color direct = direct_light(material, comp, sampler.get_1d());
+                direct *= throughput;
+                radiance += direct;
+            }
+
+            Ray scattered;
+            Color attenuation;
+
+            sampler.start_bounce(depth);
+
+            if (!m_materials.scatter(material, comp, attenuation, scattered, sampler))
+                return false;
+
+            throughput *= attenuation;
+
+            // russian roulette, dim paths are ended early and the survivors are boosted to stay unbiased
+            if (depth >= m_russian_roulette_depth)
+            {
+                const float survival = std::min(0.95f, std::max({throughput.r, throughput.g, throughput.b}));
+
+                sampler.start_bounce(depth, Sampler::kRouletteDimension);
+
+                if (survival <= 0 || sampler.get_1d() >= survival)
+                    return false;
+
+                throughput *= 1.0f / survival;
             }
 
+            ray = scattered;
+
+            return true;
+        }
+
+        /**
+         * @brief Light arriving straight from the lights at the point of `comp`, weighted by the material
+         *
+         * Point lights are a delta distribution, a scattered ray never hits one, so this is their only
+         * contribution to the image and it needs no weighting against the scatter path. With
+         * LightSampling::All every light gets a shadow ray, otherwise one light is picked and its
+         * contribution divided by the probability it was picked with.
+         *
+         * @param material Index of the hit material in the material table
+         * @param comp The hit, its over point is where the shadow rays start
+         * @param u Uniform number in [0, 1) that picks the light
+         * @return Color Reflected radiance in the 0-255 range of the sky
+         */
+        [[nodiscard]] Color direct_light(const uint32_t material, const Computation &comp, const float u) const
+        {
+            switch (m_light_sampling)
+            {
+            case LightSampling::Uniform:
+            {
+                const size_t index = std::min((size_t)(u * (float)m_lights.size()), m_lights.size() - 1);
+
+                Color radiance = light_contribution(*m_lights[index], material, comp);
+                radiance *= (float)m_lights.size();
+                return radiance;
+            }
+            case LightSampling::Tree:
+            {
+                float pdf = 0;
+                const Light *light = m_light_tree.sample(comp.m_over_point, comp.m_normal_vector, u, pdf);
+
+                if (light == nullptr || !(pdf > 0))
+                    return Karbon::BLACK;
+
+                Color radiance = light_contribution(*light, material, comp);
+                radiance *= 1.0f / pdf;
+                return radiance;
+            }
+            default:
+            {
+                Color radiance;
+
+                for (const auto &light : m_lights)
+                    radiance += light_contribution(*light, material, comp);
+
+                return radiance;
+            }
+            }
+        }
+
+        // what `light` adds at the point of `comp` through one shadow ray, black if it is blocked or behind the surface
+        [[nodiscard]] Color light_contribution(const Light &light, const uint32_t material, const Computation &comp) const
+        {
+            const Vector to_light = light.get_position() - comp.m_over_point;
+            const float distance_squared = to_light.dot(to_light);
+
+            if (distance_squared <= 0)
+                return Karbon::BLACK;
+
+            const float distance = std::sqrt(distance_squared);
+            const Vector direction = to_light / distance;
+
+            Color contribution = m_materials.evaluate(material, comp, direction);
+
+            if (contribution == Karbon::BLACK || occluded(Ray(comp.m_over_point, direction), distance))
+                return Karbon::BLACK;
+
+            contribution *= light.radiance_at(distance_squared);
+
+            return contribution;
+        }
+
+        // background gradient seen by rays that leave the scene
+        [[nodiscard]] static Color sky_color(const Ray &ray)
+        {
             const float t = (float)(0.5 * (float)(ray.m_direction.y + 1.0));
             return (1.0f - t) * Color(255.0, 255.0, 255.0) + t * Color(127.5, 178.5, 255);
         }
 
+        /**
+         * @brief Rebuilds the BVH over the bounded shapes and collects the unbounded ones (planes)
+         *
+         * With ShapeStorage::Packed the spheres and cubes are packed into their batches instead of the BVH.
+         * The material table is rebuilt as well and every shape gets the index of its material.
+         * Called by every function that adds or removes shapes. Changing the material of a shape obtained through
+         * get_shapes() requires calling this again before rendering, for a changed transform update_transforms is
+         * enough.
+         */
+        void build_bvh()
+        {
+            PROFILE_FUNCTION();
+
+            m_materials.clear();
+
+            for (const auto &shape : m_shapes)
+                shape->set_material_index(m_materials.add(*shape->get_material()));
+
+            update_transforms();
+
+            build_light_tree();
+        }
+
+        /**
+         * @brief Rebuilds the top level of the acceleration structure only, after shapes or instances were moved
+         *
+         * The BVH over the shapes (and the packed batches) is rebuilt from their world bounds. The bottom level, the
+         * triangle BVHs of the meshes and prototypes, is in object space and isn't touched, so moving an instance of
+         * a large mesh costs as much as moving a sphere. The shapes themselves must not have been added or removed,
+         * nor their materials changed, since the last build_bvh.
+         */
+        void update_transforms()
+        {
+            PROFILE_FUNCTION();
+
+            std::vector<Shape *> bounded_shapes;
+            m_unbounded_shapes.clear();
+            m_spheres.clear();
+            m_cubes.clear();
+
+            for (const auto &shape : m_shapes)
+            {
+                if (!shape->is_bounded())
+                    m_unbounded_shapes.emplace_back(shape.get());
+                else if (m_shape_storage == ShapeStorage::Packed && dynamic_cast<Sphere *>(shape.get()))
+                    m_spheres.push_back(shape.get());
+                else if (m_shape_storage == ShapeStorage::Packed && dynamic_cast<Cube *>(shape.get()))
+                    m_cubes.push_back(shape.get());
+                else
+                    bounded_shapes.emplace_back(shape.get());
+            }
+
+            m_bvh.build(bounded_shapes);
+        }
+
+        /**
+         * @brief Rebuilds the light tree over m_lights
+         *
+         * Called by build_bvh and every function that adds or removes lights. Moving a light or changing its
+         * intensity through get_lights() requires calling this (or build_bvh) again before rendering.
+         */
+        void build_light_tree()
+        {
+            m_light_tree.build(m_lights);
+        }
+
         // add shapes
         void add_shape(const std::shared_ptr<Shape> &shape)
         {
             m_shapes.emplace_back(shape);
+
+            build_bvh();
         }
 
-        // add shapes
+        // add shapes, prefer this over add_shape for many shapes since the BVH is rebuilt once
         void add_shapes(const std::vector<std::shared_ptr<Shape>> &shapes)
         {
             m_shapes.insert(m_shapes.end(), shapes.begin(), shapes.end());
+
+            build_bvh();
         }
 
         // add light
         void add_light(const std::shared_ptr<Light> &light)
         {
             m_lights.emplace_back(light);
+
+            build_light_tree();
         }
 
         // add lights
         void add_lights(const std::vector<std::shared_ptr<Light>> &lights)
         {
             m_lights.insert(m_lights.end(), lights.begin(), lights.end());
+
+            build_light_tree();
         }
 
         // get shapes
@@ -135,12 +561,16 @@ namespace Karbon
             auto it = std::find(m_lights.begin(), m_lights.end(), light);
             if (it != m_lights.end())
                 m_lights.erase(it);
+
+            build_light_tree();
         }
 
         void remove_light(const int index)
         {
             if (index < m_lights.size())
                 m_lights.erase(m_lights.begin() + index);
+
+            build_light_tree();
         }
 
         void remove_shape(const std::shared_ptr<Shape> &shape)
@@ -148,12 +578,16 @@ namespace Karbon
             auto it = std::find(m_shapes.begin(), m_shapes.end(), shape);
             if (it != m_shapes.end())
                 m_shapes.erase(it);
+
+            build_bvh();
         }
 
         void remove_shape(const int index)
         {
             if (index < m_shapes.size())
                 m_shapes.erase(m_shapes.begin() + index);
+
+            build_bvh();
         }
 
         // get shapes
@@ -180,6 +614,48 @@ namespace Karbon
             max_recurtion_level = max_depth;
         }
 
+        [[nodiscard]] ShapeStorage get_shape_storage() const
+        {
+            return m_shape_storage;
+        }
+
+        // switch how bounded shapes are stored, rebuilds the acceleration data
+        void set_shape_storage(const ShapeStorage storage)
+        {
+            if (storage == m_shape_storage)
+                return;
+
+            m_shape_storage = storage;
+
+            build_bvh();
+        }
+
+        // get the bounce limit of a material class, never more than the max depth
+        [[nodiscard]] int get_max_depth(const MaterialKind kind) const
+        {
+            const int depth = m_material_max_depth[(size_t)kind];
+
+            return depth < 0 ? max_recurtion_level : std::min(depth, max_recurtion_level);
+        }
+
+        // set the bounce limit of a material class, -1 uses the max depth
+        void set_max_depth(const MaterialKind kind, const int max_depth)
+        {
+            m_material_max_depth[(size_t)kind] = max_depth;
+        }
+
+        // get the bounce count after which paths are terminated by russian roulette
+        [[nodiscard]] int get_russian_roulette_depth() const
+        {
+            return m_russian_roulette_depth;
+        }
+
+        // set the bounce count after which paths are terminated by russian roulette
+        void set_russian_roulette_depth(const int depth)
+        {
+            m_russian_roulette_depth = depth;
+        }
+
         // get Samples Per Pixel
         int get_antialiasing_samples() const
         {
@@ -192,6 +668,44 @@ namespace Karbon
             antialiasing_samples = new_samples_per_pixel;
         }
 
+        [[nodiscard]] SamplerKind get_sampler() const
+        {
+            return m_sampler;
+        }
+
+        // how the antialiasing samples and the random decisions of their paths are distributed
+        void set_sampler(const SamplerKind sampler)
+        {
+            m_sampler = sampler;
+        }
+
+        [[nodiscard]] LightSampling get_light_sampling() const
+        {
+            return m_light_sampling;
+        }
+
+        // how direct lighting picks the lights it sends shadow rays to
+        void set_light_sampling(const LightSampling light_sampling)
+        {
+            m_light_sampling = light_sampling;
+        }
+
+        [[nodiscard]] const LightTree &get_light_tree() const
+        {
+            return m_light_tree;
+        }
+
+        [[nodiscard]] const AdaptiveSampling &get_adaptive_sampling() const
+        {
+            return m_adaptive_sampling;
+        }
+
+        // with adaptive sampling enabled antialiasing_samples is the most samples a pixel takes
+        void set_adaptive_sampling(const AdaptiveSampling &adaptive_sampling)
+        {
+            m_adaptive_sampling = adaptive_sampling;
+        }
+
         // serialize all data to a nlohmann json string object
         [[nodiscard]] std::string to_json() const noexcept
         {
@@ -201,6 +715,21 @@ namespace Karbon
 
             json["antialiasing_samples"] = antialiasing_samples;
 
+            json["sampler"] = sampler_kind_name(m_sampler);
+
+            json["light_sampling"] = light_sampling_name(m_light_sampling);
+
+            json["adaptive_sampling"] = {{"enabled", m_adaptive_sampling.m_enabled}, {"min_samples", m_adaptive_sampling.m_min_samples}, {"threshold", m_adaptive_sampling.m_threshold}};
+
+            json["russian_roulette_depth"] = m_russian_roulette_depth;
+
+            json["material_max_depth"] = m_material_max_depth;
+
+            json["shape_storage"] = m_shape_storage == ShapeStorage::Packed ? "Packed" : "BVH";
+
+            if (!m_geometry.empty())
+                json["geometries"] = m_geometry.to_json();
+
             nlohmann::json lights_json;
             for (const auto &light : m_lights)
                 lights_json.emplace_back(nlohmann::json::parse(light->to_json()));
@@ -214,12 +743,13 @@ namespace Karbon
             return json.dump();
         }
 
-        // deserialize all data from a json string object
-        void from_json(const std::string &json_string)
+        // deserialize all data from a json string object, the files of meshes are relative to base_directory
+        void from_json(const std::string &json_string, const std::string &base_directory = "")
         {
 
             m_shapes.clear();
             m_lights.clear();
+            m_geometry.clear();
 
             nlohmann::json json = nlohmann::json::parse(json_string);
 
@@ -227,6 +757,34 @@ namespace Karbon
 
             antialiasing_samples = json["antialiasing_samples"];
 
+            // older scene files don't have these
+            if (json.contains("russian_roulette_depth"))
+                m_russian_roulette_depth = json["russian_roulette_depth"];
+
+            // an unknown sampler name keeps the current one
+            if (json.contains("sampler") && !sampler_kind_from_name(json["sampler"].get<std::string>(), m_sampler))
+            {
+                debug_print("[WORLD]: ", "Unknown sampler " + json["sampler"].get<std::string>());
+            }
+
+            if (json.contains("light_sampling") && !light_sampling_from_name(json["light_sampling"].get<std::string>(), m_light_sampling))
+            {
+                debug_print("[WORLD]: ", "Unknown light sampling " + json["light_sampling"].get<std::string>());
+            }
+
+            if (json.contains("adaptive_sampling"))
+            {
+                m_adaptive_sampling.m_enabled = json["adaptive_sampling"]["enabled"];
+                m_adaptive_sampling.m_min_samples = json["adaptive_sampling"]["min_samples"];
+                m_adaptive_sampling.m_threshold = json["adaptive_sampling"]["threshold"];
+            }
+
+            if (json.contains("material_max_depth"))
+                m_material_max_depth = json["material_max_depth"];
+
+            if (json.contains("shape_storage"))
+                m_shape_storage = json["shape_storage"] == "Packed" ? ShapeStorage::Packed : ShapeStorage::BVH;
+
             for (const auto &light_json : json["lights"])
             {
                 if (light_json["type"] == "PointLight")
@@ -235,27 +793,131 @@ namespace Karbon
                 }
             }
 
+            // declared before the shapes that instance them
+            if (json.contains("geometries"))
+                for (const auto &[name, geometry_json] : json["geometries"].items())
+                    m_geometry.add_from_json(name, geometry_json, base_directory);
+
             for (const auto &shape_json : json["shapes"])
+                add_shape_from_json(shape_json, base_directory);
+
+            build_bvh();
+        }
+
+        /**
+         * @brief Makes this world a copy of `other` that can be rendered while `other` is edited
+         *
+         * Shapes, lights, materials and the prototypes of instances are copied, the triangles of meshes are shared
+         * instead of being loaded again, so nothing is read from disk and relative mesh paths don't have to be
+         * resolved a second time.
+         */
+        void copy_from(const World &other)
+        {
+            PROFILE_FUNCTION();
+
+            m_shapes.clear();
+            m_lights.clear();
+            m_geometry.copy_from(other.m_geometry);
+
+            max_recurtion_level = other.max_recurtion_level;
+            antialiasing_samples = other.antialiasing_samples;
+            m_sampler = other.m_sampler;
+            m_light_sampling = other.m_light_sampling;
+            m_adaptive_sampling = other.m_adaptive_sampling;
+            m_material_max_depth = other.m_material_max_depth;
+            m_russian_roulette_depth = other.m_russian_roulette_depth;
+            m_shape_storage = other.m_shape_storage;
+
+            for (const auto &light : other.m_lights)
+            {
+                nlohmann::json light_json = nlohmann::json::parse(light->to_json());
+
+                if (light_json["type"] == "PointLight")
+                    m_lights.emplace_back(PointLight::from_json(light_json.dump()));
+            }
+
+            for (const auto &shape : other.m_shapes)
             {
-                if (shape_json["type"] == "Sphere")
-                    m_shapes.emplace_back(Sphere::from_json(shape_json.dump()));
-                else if (shape_json["type"] == "XZPlane")
-                    m_shapes.emplace_back(XZPlane::from_json(shape_json.dump()));
-                else if (shape_json["type"] == "YZPlane")
-                    m_shapes.emplace_back(YZPlane::from_json(shape_json.dump()));
-                else if (shape_json["type"] == "XYPlane")
-                    m_shapes.emplace_back(XYPlane::from_json(shape_json.dump()));
-                if (shape_json["type"] == "Cube")
-                    m_shapes.emplace_back(Cube::from_json(shape_json.dump()));
+                if (const auto mesh = dynamic_cast<const TriangleMesh *>(shape.get()))
+                    m_shapes.emplace_back(TriangleMesh::from_json(mesh->to_json(), mesh->get_geometry()));
+                else
+                    add_shape_from_json(nlohmann::json::parse(shape->to_json()), "");
             }
+
+            build_bvh();
+        }
+
+        [[nodiscard]] const BVH &get_bvh() const
+        {
+            return m_bvh;
+        }
+
+        [[nodiscard]] const MaterialTable &get_materials() const
+        {
+            return m_materials;
+        }
+
+        // prototypes for instances and the loaded meshes, add instances of them with add_shape(s)
+        [[nodiscard]] GeometryLibrary &get_geometry()
+        {
+            return m_geometry;
+        }
+
+        [[nodiscard]] const GeometryLibrary &get_geometry() const
+        {
+            return m_geometry;
         }
 
     private:
+        // one entry of "shapes", mesh files are resolved against base_directory
+        void add_shape_from_json(const nlohmann::json &shape_json, const std::string &base_directory)
+        {
+            if (shape_json["type"] == "Sphere")
+                m_shapes.emplace_back(Sphere::from_json(shape_json.dump()));
+            else if (shape_json["type"] == "XZPlane")
+                m_shapes.emplace_back(XZPlane::from_json(shape_json.dump()));
+            else if (shape_json["type"] == "YZPlane")
+                m_shapes.emplace_back(YZPlane::from_json(shape_json.dump()));
+            else if (shape_json["type"] == "XYPlane")
+                m_shapes.emplace_back(XYPlane::from_json(shape_json.dump()));
+            else if (shape_json["type"] == "Cube")
+                m_shapes.emplace_back(Cube::from_json(shape_json.dump()));
+            else if (shape_json["type"] == "Mesh")
+            {
+                // a mesh whose file can't be loaded is left out of the scene
+                if (auto geometry = m_geometry.load_mesh(shape_json["file"].get<std::string>(), base_directory))
+                    m_shapes.emplace_back(TriangleMesh::from_json(shape_json.dump(), std::move(geometry)));
+            }
+            else if (shape_json["type"] == "Instance")
+            {
+                // so is an instance of an unknown geometry
+                if (auto instance = m_geometry.instance_from_json(shape_json.dump()))
+                    m_shapes.emplace_back(instance);
+            }
+        }
+
         std::vector<std::shared_ptr<Shape>> m_shapes;
         std::vector<std::shared_ptr<Light>> m_lights;
+        GeometryLibrary m_geometry; // shared by the Instances in m_shapes
+
+        // acceleration data, raw pointers into m_shapes
+        BVH m_bvh;
+        SphereBatch m_spheres;
+        CubeBatch m_cubes;
+        std::vector<Shape *> m_unbounded_shapes;
+        MaterialTable m_materials; // indexed by Shape::get_material_index()
+        LightTree m_light_tree;    // raw pointers into m_lights
+        ShapeStorage m_shape_storage = ShapeStorage::BVH;
 
         int max_recurtion_level = 7;
         int antialiasing_samples = 1;
+        SamplerKind m_sampler = SamplerKind::Sobol;
+        LightSampling m_light_sampling = LightSampling::Tree;
+        AdaptiveSampling m_adaptive_sampling;
+
+        // per MaterialKind bounce limits, -1 falls back to max_recurtion_level
+        std::array<int, (size_t)MaterialKind::Count> m_material_max_depth = {-1, -1, -1};
+        int m_russian_roulette_depth = 3;
     };
 
 } // namespace Karbon
@@ -3,7 +3,6 @@
 auto scene = Karbon::Scene(Karbon::Camera(800, 600, (float)std::numbers::pi / 3), Karbon::World(0));
 
 std::shared_ptr<Karbon::Color[]> canvas;
-std::thread render_thread;
 
 #ifdef _WIN32
 
@@ -51,7 +50,10 @@ public:
             if (ImGui::Button("Load Scene"))
             {
                 if (strlen(path) > 0)
+                {
                     scene.load_scene(path);
+                    m_scene_edited = true;
+                }
             }
 
             { // save scene
@@ -87,6 +89,7 @@ public:
                     scene.m_world.remove_shape(shapes[selected]);
 
                 selected = 0;
+                m_scene_edited = true;
             }
 
             ImGui::SetNextItemOpen(true, ImGuiCond_Once);
@@ -97,6 +100,7 @@ public:
                     {
                         auto sphere = std::make_shared<Karbon::Sphere>(Karbon::Sphere());
                         scene.m_world.add_shape(sphere);
+                        m_scene_edited = true;
                     }
 
                     ImGui::SameLine();
@@ -105,12 +109,14 @@ public:
                     {
                         auto cube = std::make_shared<Karbon::Cube>(Karbon::Cube());
                         scene.m_world.add_shape(cube);
+                        m_scene_edited = true;
                     }
 
                     if (ImGui::Button("Add XZ-Plane"))
                     {
                         auto plane = std::make_shared<Karbon::XZPlane>(Karbon::XZPlane());
                         scene.m_world.add_shape(plane);
+                        m_scene_edited = true;
                     }
 
                     ImGui::SameLine();
@@ -119,6 +125,7 @@ public:
                     {
                         auto plane = std::make_shared<Karbon::YZPlane>(Karbon::YZPlane());
                         scene.m_world.add_shape(plane);
+                        m_scene_edited = true;
                     }
 
                     ImGui::SameLine();
@@ -127,6 +134,7 @@ public:
                     {
                         auto plane = std::make_shared<Karbon::XYPlane>(Karbon::XYPlane());
                         scene.m_world.add_shape(plane);
+                        m_scene_edited = true;
                     }
                 }
 
@@ -149,6 +157,7 @@ public:
                     {
                         auto light = std::make_shared<Karbon::PointLight>(Karbon::PointLight());
                         scene.m_world.add_light(light);
+                        m_scene_edited = true;
                     }
                 }
 
@@ -215,16 +224,16 @@ public:
 
                             // imgui text output
                             ImGui::Text("Translation: (x, y, z):");
-                            ImGui::SliderFloat3("##Translation", transformation, -50, 50);
+                            m_scene_edited |= ImGui::SliderFloat3("##Translation", transformation, -50, 50);
 
                             ImGui::Spacing();
 
                             ImGui::Text("Rotation: (x, y, z):");
-                            ImGui::SliderFloat3("##Rotation", rotation, -180, 180);
+                            m_scene_edited |= ImGui::SliderFloat3("##Rotation", rotation, -180, 180);
 
                             ImGui::Spacing();
                             ImGui::Text("Scale: (x, y, z):");
-                            ImGui::SliderFloat3("##Scale", scale, 0.1f, 10);
+                            m_scene_edited |= ImGui::SliderFloat3("##Scale", scale, 0.1f, 10);
 
                             shape->transform_deg(transformation, rotation, scale);
                         }
@@ -238,7 +247,7 @@ public:
 
                                 float position[3] = {position_vec.x, position_vec.y, position_vec.z};
 
-                                ImGui::InputFloat3("Position", (float *)&position);
+                                m_scene_edited |= ImGui::InputFloat3("Position", (float *)&position);
 
                                 light->set_position(position);
                             }
@@ -267,7 +276,7 @@ public:
                             }
 
                             const char *materials[] = {"Lambertian", "Metal", "Dielectric"};
-                            ImGui::Combo("Material Selection:", &item_current, materials, IM_ARRAYSIZE(materials));
+                            m_scene_edited |= ImGui::Combo("Material Selection:", &item_current, materials, IM_ARRAYSIZE(materials));
 
                             float roughness = 0;
                             float ref_idx = 1.05f;
@@ -289,7 +298,7 @@ public:
 
                                 roughness = ((Karbon::Metal *)shape->get_material().get())->get_roughness();
 
-                                ImGui::SliderFloat("Roughness", &roughness, 0.0f, 1.0f);
+                                m_scene_edited |= ImGui::SliderFloat("Roughness", &roughness, 0.0f, 1.0f);
 
                                 ((Karbon::Metal *)shape->get_material().get())->set_roughness(roughness);
 
@@ -302,7 +311,7 @@ public:
 
                                 ref_idx = shape->get_material().get()->get_refractive_index();
 
-                                ImGui::SliderFloat("Refractive Index", &ref_idx, 1.05f, 3.0f);
+                                m_scene_edited |= ImGui::SliderFloat("Refractive Index", &ref_idx, 1.05f, 3.0f);
 
                                 shape->get_material().get()->set_refractive_index(ref_idx);
 
@@ -315,7 +324,7 @@ public:
 
                             float color_vec[3] = {color.r, color.g, color.b};
 
-                            ImGui::ColorEdit3("Material Color", (float *)&color_vec);
+                            m_scene_edited |= ImGui::ColorEdit3("Material Color", (float *)&color_vec);
 
                             shape->get_material()->set_color(color_vec);
 
@@ -408,9 +417,17 @@ public:
 
                             float color_vec[3] = {color.r, color.g, color.b};
 
-                            ImGui::ColorEdit3("Light Color", (float *)&color_vec);
+                            m_scene_edited |= ImGui::ColorEdit3("Light Color", (float *)&color_vec);
 
                             light->set_SDR_intensity(color_vec);
+
+                            float strength = light->get_strength();
+
+                            if (ImGui::SliderFloat("##Light strength", &strength, 0.1f, 10000.0f, "Strength: %.1f", ImGuiSliderFlags_Logarithmic))
+                            {
+                                light->set_strength(strength);
+                                m_scene_edited = true;
+                            }
                         }
 
                         ImGui::EndTabItem();
@@ -440,7 +457,7 @@ public:
 
                     ImGui::Text("Resolution: (w, h):");
 
-                    ImGui::InputFloat2("##Render Resolution", (float *)&size);
+                    m_scene_edited |= ImGui::InputFloat2("##Render Resolution", (float *)&size);
 
                     scene.m_camera.set_width((int)size[0]);
                     scene.m_camera.set_height((int)size[1]);
@@ -451,17 +468,120 @@ public:
                 {
                     auto render_depth = scene.m_world.get_max_recurtion_level();
 
-                    ImGui::SliderInt("##Render Depth", &render_depth, 1, 100, "Render Depth : %d", ImGuiSliderFlags_Logarithmic);
+                    m_scene_edited |= ImGui::SliderInt("##Render Depth", &render_depth, 1, 100, "Render Depth : %d", ImGuiSliderFlags_Logarithmic);
 
                     scene.m_world.set_max_recurtion_level(render_depth);
                 }
 
+                {
+                    int roulette_depth = scene.m_world.get_russian_roulette_depth();
+
+                    m_scene_edited |= ImGui::SliderInt("##Roulette Depth", &roulette_depth, 0, 100, "Russian Roulette after: %d", ImGuiSliderFlags_Logarithmic);
+
+                    scene.m_world.set_russian_roulette_depth(roulette_depth);
+                }
+
+                if (ImGui::TreeNode("Depth per material"))
+                {
+                    const char *kind_names[] = {"Diffuse", "Metal", "Dielectric"};
+
+                    for (size_t kind = 0; kind < (size_t)Karbon::MaterialKind::Count; kind++)
+                    {
+                        int depth = scene.m_world.get_max_depth((Karbon::MaterialKind)kind);
+
+                        std::string label = std::string("##Depth ") + kind_names[kind];
+                        std::string format = std::string(kind_names[kind]) + " Depth: %d";
+
+                        if (ImGui::SliderInt(label.c_str(), &depth, 0, scene.m_world.get_max_recurtion_level(), format.c_str()))
+                        {
+                            scene.m_world.set_max_depth((Karbon::MaterialKind)kind, depth);
+                            m_scene_edited = true;
+                        }
+                    }
+
+                    ImGui::TreePop();
+                }
+
                 {
                     int antialiasing_samples = scene.m_world.get_antialiasing_samples();
 
-                    ImGui::SliderInt("##AA samples", &antialiasing_samples, 1, 100, "AA Samples: %d", ImGuiSliderFlags_Logarithmic);
+                    m_scene_edited |= ImGui::SliderInt("##AA samples", &antialiasing_samples, 1, 100, "AA Samples: %d", ImGuiSliderFlags_Logarithmic);
 
                     scene.m_world.set_antialiasing_samples(antialiasing_samples);
+
+                    int sampler = (int)scene.m_world.get_sampler();
+
+                    const char *samplers[] = {"Random", "Stratified", "Sobol", "Blue Noise"};
+                    if (ImGui::Combo("Sampler", &sampler, samplers, IM_ARRAYSIZE(samplers)))
+                    {
+                        scene.m_world.set_sampler((Karbon::SamplerKind)sampler);
+                        m_scene_edited = true;
+                    }
+
+                    int light_sampling = (int)scene.m_world.get_light_sampling();
+
+                    const char *light_samplings[] = {"All Lights", "Uniform", "Light Tree"};
+                    if (ImGui::Combo("Light Sampling", &light_sampling, light_samplings, IM_ARRAYSIZE(light_samplings)))
+                    {
+                        scene.m_world.set_light_sampling((Karbon::LightSampling)light_sampling);
+                        m_scene_edited = true;
+                    }
+
+                    Karbon::AdaptiveSampling adaptive = scene.m_world.get_adaptive_sampling();
+
+                    m_scene_edited |= ImGui::Checkbox("Adaptive Sampling", &adaptive.m_enabled);
+
+                    if (adaptive.m_enabled)
+                    {
+                        m_scene_edited |= ImGui::SliderInt("##Min samples", &adaptive.m_min_samples, 1, antialiasing_samples, "Min Samples: %d", ImGuiSliderFlags_Logarithmic);
+                        m_scene_edited |= ImGui::SliderFloat("##Error threshold", &adaptive.m_threshold, 0.0005f, 0.05f, "Error Threshold: %.4f", ImGuiSliderFlags_Logarithmic);
+                    }
+
+                    scene.m_world.set_adaptive_sampling(adaptive);
+                }
+
+                ImGui::Text("Scheduling:");
+
+                {
+                    const char *render_modes[] = {"Rows", "Tiles", "Progressive"};
+                    if (ImGui::Combo("Render Mode", &m_render_mode, render_modes, IM_ARRAYSIZE(render_modes)) && m_render_mode != 2)
+                        m_progressive.stop();
+
+                    if (m_render_mode == 2)
+                    {
+                        bool packet_tracing = scene.m_camera.get_packet_tracing();
+                        if (ImGui::Checkbox("Packet Tracing", &packet_tracing))
+                        {
+                            scene.m_camera.set_packet_tracing(packet_tracing);
+                            m_scene_edited = true;
+                        }
+                    }
+
+                    if (m_render_mode == 1)
+                    {
+                        ImGui::SliderInt("##Tile Size", &m_tile_size, 4, 128, "Tile Size: %d", ImGuiSliderFlags_Logarithmic);
+
+                        const char *tile_orders[] = {"Scanline", "Morton", "Hilbert"};
+                        ImGui::Combo("Tile Order", &m_tile_order, tile_orders, IM_ARRAYSIZE(tile_orders));
+
+                        bool packet_tracing = scene.m_camera.get_packet_tracing();
+                        if (ImGui::Checkbox("Packet Tracing", &packet_tracing))
+                        {
+                            scene.m_camera.set_packet_tracing(packet_tracing);
+                            m_scene_edited = true;
+                        }
+                    }
+                }
+
+                {
+                    int shape_storage = (int)scene.m_world.get_shape_storage();
+
+                    const char *shape_storages[] = {"BVH", "Packed"};
+                    if (ImGui::Combo("Shape Storage", &shape_storage, shape_storages, IM_ARRAYSIZE(shape_storages)))
+                    {
+                        scene.m_world.set_shape_storage((Karbon::ShapeStorage)shape_storage);
+                        m_scene_edited = true;
+                    }
                 }
 
                 ImGui::TreePop(); // Render Settings
@@ -476,7 +596,29 @@ public:
                 Render();
             }
 
+            if (m_render_mode == 2 && !is_first_render)
+            {
+                ImGui::SameLine();
+
+                if (ImGui::Button("Stop"))
+                    m_progressive.stop();
+
+                ImGui::Text("Samples: %d%s", m_progressive_samples, m_progressive.is_running() ? " (running)" : "");
+            }
+
             ImGui::Text("Last render: %.3fms", m_LastRenderTime);
+
+            if (m_render_mode == 1 && !is_first_render)
+            {
+                auto worker_times = scene.m_camera.get_worker_times();
+
+                if (!worker_times.empty())
+                {
+                    auto [min_time, max_time] = std::minmax_element(worker_times.begin(), worker_times.end());
+
+                    ImGui::Text("Tiles: %d, worker busy time: %.3fms - %.3fms", (int)scene.m_camera.get_tile_stats().size(), *min_time, *max_time);
+                }
+            }
         }
 
         if (!is_first_render)
@@ -500,6 +642,9 @@ public:
 
         ImGui::End(); // World Outline
 
+        if (m_render_mode == 2 && !is_first_render)
+            UpdateProgressive();
+
         ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
         ImGui::Begin("Editor");
 
@@ -526,7 +671,64 @@ public:
 
         // canvas = a2.get();
 
-        canvas = scene.m_camera.render_multi_threaded(scene.m_world);
+        // shapes may have been moved through the details panel since the last render
+        scene.m_world.build_bvh();
+
+        if (m_render_mode == 2)
+        {
+            // the first snapshot is picked up by UpdateProgressive a few milliseconds later
+            m_progressive.start(scene.m_camera, scene.m_world);
+            m_scene_edited = false;
+            m_progressive_samples = 0;
+
+            m_LastRenderTime = timer.elapsed_millis();
+            return;
+        }
+
+        if (m_render_mode == 1)
+            canvas = scene.m_camera.render_tiled(scene.m_world, kCORE_COUNT, m_tile_size, (Karbon::TileOrder)m_tile_order);
+        else
+            canvas = scene.m_camera.render_multi_threaded(scene.m_world);
+
+        UploadImage(scene.m_camera.is_finished());
+
+        is_file_saved = false;
+
+        m_LastRenderTime = timer.elapsed_millis();
+    }
+
+    // restarts the progressive render when the scene was edited and shows its latest snapshot
+    void UpdateProgressive()
+    {
+        PROFILE_FUNCTION();
+
+        if (m_scene_edited)
+        {
+            scene.m_world.build_bvh();
+            m_progressive.start(scene.m_camera, scene.m_world);
+            m_scene_edited = false;
+            m_progressive_samples = 0;
+        }
+
+        int samples = 0;
+
+        if (auto snapshot = m_progressive.take_snapshot(samples))
+        {
+            canvas = snapshot;
+            m_progressive_samples = samples;
+
+            UploadImage(true);
+
+            is_file_saved = false;
+        }
+    }
+
+    // copies canvas to the viewport image, black if there is no finished image
+    void UploadImage(const bool has_image)
+    {
+        // canvas always has the size of the camera, the viewport may not have caught up yet
+        m_ViewportWidth = scene.m_camera.get_width();
+        m_ViewportHeight = scene.m_camera.get_height();
 
         if (!m_Image || m_ViewportWidth != m_Image->GetWidth() || m_ViewportHeight != m_Image->GetHeight())
         {
@@ -535,7 +737,7 @@ public:
             m_ImageData = new uint32_t[m_ViewportWidth * m_ViewportHeight];
         }
 
-        if (scene.m_camera.is_finished())
+        if (has_image)
         {
             for (uint32_t i = 0; i < m_ViewportWidth * m_ViewportHeight; i++)
             {
@@ -547,10 +749,6 @@ public:
                 m_ImageData[i] = 0;
 
         m_Image->SetData(m_ImageData);
-
-        is_file_saved = false;
-
-        m_LastRenderTime = timer.elapsed_millis();
     }
 
 private:
@@ -560,6 +758,14 @@ private:
 
     float m_LastRenderTime = 0.0f;
 
+    int m_render_mode = 1;
+    int m_tile_size = 16;
+    int m_tile_order = (int)Karbon::TileOrder::Morton;
+
+    Karbon::ProgressiveRenderer m_progressive;
+    bool m_scene_edited = false; // set by the widgets that change the camera or world, restarts the progressive render
+    int m_progressive_samples = 0;
+
     bool is_first_render = true;
     float m_file_save_time = 0.0f;
     bool is_file_saved = false;
@@ -592,37 +798,23 @@ Walnut::Application *Walnut::CreateApplication([[maybe_unused]] int argc, [[mayb
 
 #else
 
+// The Walnut GUI is Windows only, elsewhere render the default scene once and write it to disk.
+// Use the karbon-RayTracer-cli target to render scene files.
 int main()
 {
-    // Instrumentor::Get().beginSession("main");
+#if PROFILING
+    Instrumentor::Get().beginSession("main");
+#endif
 
     scene.m_camera.transform(Karbon::Point(0, 1.5, -5), Karbon::Point(0, 1, 0), Karbon::Vector(0, 1, 0));
 
-    canvas = scene.m_camera.classic_render_multi_threaded(world, 4);
+    canvas = scene.m_camera.render_tiled(scene.m_world);
 
+#if PROFILING
     Instrumentor::Get().endSession();
+#endif
 
-    // Get a console handle
-    HWND myconsole = GetConsoleWindow();
-    // Get a handle to device context
-    HDC mydc = GetDC(myconsole);
-
-    // Draw pixels
-    for (int16_t i = 0; i < scene.m_camera.get_width(); i++)
-    {
-
-        for (int16_t j = 0; j < scene.m_camera.get_height(); j++)
-        {
-            COLORREF COLOR = RGB(canvas.get()[j * scene.m_camera.get_width() + i].r, canvas.get()[j * scene.m_camera.get_width() + i].g, canvas.get()[j * scene.m_camera.get_width() + i].b);
-
-            SetPixel(mydc, i, j, COLOR);
-        }
-    }
-
-    ReleaseDC(myconsole, mydc);
-
-    std::cin.ignore();
-    return 0;
+    return Karbon::save_image(canvas, scene.m_camera.get_width(), scene.m_camera.get_height(), "render.jpg") > 0 ? 0 : 1;
 }
 
-#endif
\ No newline at end of file
+#endif
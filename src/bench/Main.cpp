@@ -0,0 +1,745 @@
+#include <Karbon.hpp>
+
+#include <iomanip>
+
+#include "Scenes.hpp"
+
+// Ray throughput benchmark: primary rays, secondary (bounce) rays, shadow rays and full path renders per scene and thread count
+
+#ifndef KARBON_SCENE_DIRECTORY
+#define KARBON_SCENE_DIRECTORY "bin/x64"
+#endif
+
+struct BenchmarkOptions
+{
+    std::string scene_directory = KARBON_SCENE_DIRECTORY;
+    std::string json_path;
+    std::vector<std::string> scene_filter;
+    std::vector<int> thread_counts;
+    int count = 1000;
+    int width = 320;
+    int height = 240;
+    int samples = 4;
+    int depth = 7;
+    int repeat = 3;
+    int light_count = 0;
+    int light_time = 1000;
+    Karbon::ShapeStorage storage = Karbon::ShapeStorage::BVH;
+};
+
+struct BenchmarkResult
+{
+    std::string scene;
+    size_t shapes;
+    std::string kind;
+    int threads;
+    uint64_t rays;
+    double seconds;
+
+    [[nodiscard]] double mrays_per_second() const
+    {
+        return seconds > 0 ? rays / seconds / 1e6 : 0;
+    }
+};
+
+// image error of one light sampling strategy after rendering for a fixed time
+struct LightSamplingResult
+{
+    std::string scene;
+    std::string sampling;
+    int threads;
+    int samples;
+    double rmse;
+};
+
+// memory and rebuild cost of a scene made of instances
+struct InstancingResult
+{
+    std::string scene;
+    size_t instances;
+    size_t geometries;
+    size_t geometry_bytes; // the shared triangles and BVHs
+    size_t copied_bytes;   // the same if every instance had its own copy
+    double rebuild_seconds;
+};
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "\n"
+              << "Options:\n"
+              << "  --json <file>           Also write the results as json\n"
+              << "  --scenes <a,b,...>      Only run scenes whose name starts with one of these\n"
+              << "  --threads <1,2,...>     Thread counts to measure, default powers of two up to " << kCORE_COUNT << "\n"
+              << "  --count <n>             Shapes in the procedural scenes, default 1000\n"
+              << "  --width <n>             Image width, default 320\n"
+              << "  --height <n>            Image height, default 240\n"
+              << "  --samples <n>           Samples per pixel of the full path renders, default 4\n"
+              << "  --depth <n>             Maximum bounce depth of the full path renders, default 7\n"
+              << "  --repeat <n>            Runs per measurement, the fastest one is reported, default 3\n"
+              << "  --scene-dir <dir>       Directory holding Default_Scene.json\n"
+              << "  --storage <bvh|packed>  How the scenes store bounded shapes, default bvh\n"
+              << "  --lights <n>            Add a scene with n point lights and compare light sampling strategies on it\n"
+              << "  --light-time <ms>       Render time per strategy in that comparison, default 1000\n"
+              << "  -h, --help              Show this message\n";
+}
+
+[[nodiscard]] std::vector<std::string> split(const std::string &text, const char delimiter)
+{
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+
+    while (std::getline(stream, part, delimiter))
+        if (!part.empty())
+            parts.emplace_back(part);
+
+    return parts;
+}
+
+[[nodiscard]] bool parse_arguments(const int argc, char **argv, BenchmarkOptions &options)
+{
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+
+            if (arg == "-h" || arg == "--help")
+                return false;
+
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << "\n";
+                return false;
+            }
+
+            const std::string value = argv[++i];
+
+            if (arg == "--json")
+                options.json_path = value;
+            else if (arg == "--scenes")
+                options.scene_filter = split(value, ',');
+            else if (arg == "--threads")
+            {
+                for (const auto &count : split(value, ','))
+                    options.thread_counts.emplace_back(std::stoi(count));
+            }
+            else if (arg == "--count")
+                options.count = std::stoi(value);
+            else if (arg == "--width")
+                options.width = std::stoi(value);
+            else if (arg == "--height")
+                options.height = std::stoi(value);
+            else if (arg == "--samples")
+                options.samples = std::stoi(value);
+            else if (arg == "--depth")
+                options.depth = std::stoi(value);
+            else if (arg == "--repeat")
+                options.repeat = std::stoi(value);
+            else if (arg == "--lights")
+                options.light_count = std::stoi(value);
+            else if (arg == "--light-time")
+                options.light_time = std::stoi(value);
+            else if (arg == "--scene-dir")
+                options.scene_directory = value;
+            else if (arg == "--storage")
+            {
+                if (value != "bvh" && value != "packed")
+                {
+                    std::cerr << "Unknown storage: " << value << "\n";
+                    return false;
+                }
+
+                options.storage = value == "packed" ? Karbon::ShapeStorage::Packed : Karbon::ShapeStorage::BVH;
+            }
+            else
+            {
+                std::cerr << "Unknown option: " << arg << "\n";
+                return false;
+            }
+        }
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Invalid numeric argument\n";
+        return false;
+    }
+
+    if (options.thread_counts.empty())
+    {
+        for (int threads = 1; threads < kCORE_COUNT; threads *= 2)
+            options.thread_counts.emplace_back(threads);
+
+        options.thread_counts.emplace_back(kCORE_COUNT);
+    }
+
+    for (int &threads : options.thread_counts)
+    {
+        if (threads < 1)
+        {
+            std::cerr << "Thread counts have to be positive\n";
+            return false;
+        }
+
+        // everything is measured on the shared pool, which has one worker per core, so the count reported is the one used
+        if (threads > Karbon::ThreadPool::Get().size())
+        {
+            std::cerr << "Measuring " << Karbon::ThreadPool::Get().size() << " threads instead of " << threads << ", one per core\n";
+            threads = Karbon::ThreadPool::Get().size();
+        }
+    }
+
+    // clamped counts may repeat
+    for (size_t i = 0; i < options.thread_counts.size(); i++)
+        options.thread_counts.erase(std::remove(options.thread_counts.begin() + (std::ptrdiff_t)i + 1, options.thread_counts.end(), options.thread_counts[i]), options.thread_counts.end());
+
+    return options.count > 0 && options.width > 0 && options.height > 0 && options.samples > 0 && options.depth > 0 && options.repeat > 0 && options.light_count >= 0 && options.light_time > 0;
+}
+
+// traces every ray once (closest hit only) split into chunks over the pool, returns the best time of `repeat` runs
+[[nodiscard]] double trace_rays(const Karbon::World &world, const std::vector<Karbon::Ray> &rays, const int threads, const int repeat)
+{
+    constexpr size_t kChunkSize = 1024;
+    const size_t chunk_count = (rays.size() + kChunkSize - 1) / kChunkSize;
+
+    double best = std::numeric_limits<double>::infinity();
+
+    for (int run = 0; run < repeat; run++)
+    {
+        std::atomic<uint32_t> hit_count = 0;
+
+        Karbon::Timer timer;
+
+        Karbon::ThreadPool::Get().run(
+            chunk_count, [&](const size_t chunk, [[maybe_unused]] const int worker)
+            {
+                uint32_t hits = 0;
+
+                for (size_t i = chunk * kChunkSize; i < std::min(rays.size(), (chunk + 1) * kChunkSize); i++)
+                    hits += world.closest_hit(rays[i]).is_valid();
+
+                hit_count += hits; },
+            threads);
+
+        best = std::min(best, (double)timer.elapsed());
+    }
+
+    return best;
+}
+
+// tests every shadow ray once against its distance, with the occlusion query or a bounded closest hit
+[[nodiscard]] double trace_shadow_rays(const Karbon::World &world, const std::vector<std::pair<Karbon::Ray, float>> &rays, const bool any_hit, const int threads, const int repeat)
+{
+    constexpr size_t kChunkSize = 1024;
+    const size_t chunk_count = (rays.size() + kChunkSize - 1) / kChunkSize;
+
+    double best = std::numeric_limits<double>::infinity();
+
+    for (int run = 0; run < repeat; run++)
+    {
+        std::atomic<uint32_t> blocked_count = 0;
+
+        Karbon::Timer timer;
+
+        Karbon::ThreadPool::Get().run(
+            chunk_count, [&](const size_t chunk, [[maybe_unused]] const int worker)
+            {
+                uint32_t blocked = 0;
+
+                for (size_t i = chunk * kChunkSize; i < std::min(rays.size(), (chunk + 1) * kChunkSize); i++)
+                {
+                    const auto &[ray, distance] = rays[i];
+                    blocked += any_hit ? world.occluded(ray, distance) : world.closest_hit(ray, 0, distance).is_valid();
+                }
+
+                blocked_count += blocked; },
+            threads);
+
+        best = std::min(best, (double)timer.elapsed());
+    }
+
+    return best;
+}
+
+// traces every packet once (closest hits only) over the pool, returns the best time of `repeat` runs
+[[nodiscard]] double trace_packets(const Karbon::World &world, const std::vector<Karbon::RayPacket> &packets, const int threads, const int repeat)
+{
+    constexpr size_t kChunkSize = 64;
+    const size_t chunk_count = (packets.size() + kChunkSize - 1) / kChunkSize;
+
+    double best = std::numeric_limits<double>::infinity();
+
+    for (int run = 0; run < repeat; run++)
+    {
+        std::atomic<uint32_t> hit_count = 0;
+
+        Karbon::Timer timer;
+
+        Karbon::ThreadPool::Get().run(
+            chunk_count, [&](const size_t chunk, [[maybe_unused]] const int worker)
+            {
+                uint32_t hits = 0;
+                Karbon::PacketHits packet_hits;
+
+                for (size_t i = chunk * kChunkSize; i < std::min(packets.size(), (chunk + 1) * kChunkSize); i++)
+                {
+                    world.closest_hit(packets[i], packet_hits);
+
+                    for (uint32_t ray = 0; ray < Karbon::RayPacket::kSize; ray++)
+                        hits += packet_hits[ray].is_valid();
+                }
+
+                hit_count += hits; },
+            threads);
+
+        best = std::min(best, (double)timer.elapsed());
+    }
+
+    return best;
+}
+
+// traces every shadow packet once with the packet any-hit query over the pool, returns the best time of `repeat` runs
+[[nodiscard]] double trace_shadow_packets(const Karbon::World &world, const std::vector<Karbon::RayPacket> &packets, const int threads, const int repeat)
+{
+    constexpr size_t kChunkSize = 64;
+    const size_t chunk_count = (packets.size() + kChunkSize - 1) / kChunkSize;
+
+    double best = std::numeric_limits<double>::infinity();
+
+    for (int run = 0; run < repeat; run++)
+    {
+        std::atomic<uint32_t> blocked_count = 0;
+
+        Karbon::Timer timer;
+
+        Karbon::ThreadPool::Get().run(
+            chunk_count, [&](const size_t chunk, [[maybe_unused]] const int worker)
+            {
+                uint32_t blocked = 0;
+
+                for (size_t i = chunk * kChunkSize; i < std::min(packets.size(), (chunk + 1) * kChunkSize); i++)
+                    blocked += (uint32_t)std::popcount(world.occluded(packets[i]));
+
+                blocked_count += blocked; },
+            threads);
+
+        best = std::min(best, (double)timer.elapsed());
+    }
+
+    return best;
+}
+
+// the same camera rays as make_primary_rays grouped into 4x4 pixel packets
+[[nodiscard]] std::vector<Karbon::RayPacket> make_primary_packets(const Karbon::Camera &camera)
+{
+    std::vector<Karbon::RayPacket> packets;
+
+    for (int y0 = 0; y0 < camera.get_height(); y0 += static_cast<int>(Karbon::RayPacket::kSide))
+    {
+        for (int x0 = 0; x0 < camera.get_width(); x0 += static_cast<int>(Karbon::RayPacket::kSide))
+        {
+            Karbon::RayPacket &packet = packets.emplace_back();
+
+            for (uint32_t i = 0; i < Karbon::RayPacket::kSize; i++)
+            {
+                const int x = x0 + (int)(i % Karbon::RayPacket::kSide);
+                const int y = y0 + (int)(i / Karbon::RayPacket::kSide);
+
+                if (x < camera.get_width() && y < camera.get_height())
+                    packet.set(i, camera.ray_for_pixel((float)x, (float)y));
+            }
+        }
+    }
+
+    return packets;
+}
+
+// camera rays through the center of every pixel
+[[nodiscard]] std::vector<Karbon::Ray> make_primary_rays(const Karbon::Camera &camera)
+{
+    std::vector<Karbon::Ray> rays;
+    rays.reserve((size_t)camera.get_width() * (size_t)camera.get_height());
+
+    for (int y = 0; y < camera.get_height(); y++)
+        for (int x = 0; x < camera.get_width(); x++)
+            rays.emplace_back(camera.ray_for_pixel((float)x, (float)y));
+
+    return rays;
+}
+
+// one scattered ray per primary hit, these are incoherent like the rays of later bounces
+[[nodiscard]] std::vector<Karbon::Ray> make_secondary_rays(const Karbon::World &world, const std::vector<Karbon::Ray> &primary_rays)
+{
+    std::vector<Karbon::Ray> rays;
+
+    for (size_t i = 0; i < primary_rays.size(); i++)
+    {
+        const Karbon::Ray &ray = primary_rays[i];
+        Karbon::Hit hit = world.closest_hit(ray);
+
+        if (!hit.is_valid())
+            continue;
+
+        const Karbon::MaterialTable &materials = world.get_materials();
+        const uint32_t material = hit.m_object->get_material_index();
+
+        Karbon::Intersection isect(hit.m_t, *hit.m_object, hit.m_primitive);
+
+        auto comp = materials.is_refractive(material) ? isect.prepare_computation(ray, world.intersects(ray)) : isect.prepare_computation(ray);
+
+        Karbon::Ray scattered;
+        Karbon::Color attenuation;
+        Karbon::Sampler sampler(Karbon::SamplerKind::Random, (uint32_t)i, 0, 0, 1);
+
+        if (materials.scatter(material, comp, attenuation, scattered, sampler))
+            rays.emplace_back(scattered);
+    }
+
+    return rays;
+}
+
+// one shadow ray per primary hit towards the first light of the scene, or a point above the scenes without one
+[[nodiscard]] std::vector<std::pair<Karbon::Ray, float>> make_shadow_rays(const Karbon::World &world, const std::vector<Karbon::Ray> &primary_rays)
+{
+    const Karbon::Point light = world.get_lights().empty() ? Karbon::Point(2.0f, 8.0f, -4.0f) : world.get_lights().front()->get_position();
+
+    std::vector<std::pair<Karbon::Ray, float>> rays;
+
+    for (const auto &ray : primary_rays)
+    {
+        Karbon::Hit hit = world.closest_hit(ray);
+
+        if (!hit.is_valid())
+            continue;
+
+        const auto comp = Karbon::Intersection(hit.m_t, *hit.m_object, hit.m_primitive).prepare_computation(ray);
+        const Karbon::Vector to_light = light - comp.m_over_point;
+        const float distance = to_light.magnitude();
+
+        rays.emplace_back(Karbon::Ray(comp.m_over_point, to_light / distance), distance);
+    }
+
+    return rays;
+}
+
+// the rays of make_shadow_rays traced from the hits of the primary packets, so each packet holds a 4x4 pixel block
+[[nodiscard]] std::vector<Karbon::RayPacket> make_shadow_packets(const Karbon::World &world, const std::vector<Karbon::RayPacket> &primary_packets)
+{
+    const Karbon::Point light = world.get_lights().empty() ? Karbon::Point(2.0f, 8.0f, -4.0f) : world.get_lights().front()->get_position();
+
+    std::vector<Karbon::RayPacket> packets;
+    Karbon::PacketHits hits;
+
+    for (const auto &primary : primary_packets)
+    {
+        world.closest_hit(primary, hits);
+
+        Karbon::RayPacket &packet = packets.emplace_back();
+
+        for (uint32_t rays = primary.m_active; rays != 0; rays &= rays - 1)
+        {
+            const uint32_t ray = (uint32_t)std::countr_zero(rays);
+            const Karbon::Hit &hit = hits[ray];
+
+            if (!hit.is_valid())
+                continue;
+
+            const auto comp = Karbon::Intersection(hit.m_t, *hit.m_object, hit.m_primitive).prepare_computation(primary.m_rays[ray]);
+            const Karbon::Vector to_light = light - comp.m_over_point;
+            const float distance = to_light.magnitude();
+
+            packet.set(ray, Karbon::Ray(comp.m_over_point, to_light / distance), distance);
+        }
+
+        if (packet.m_active == 0)
+            packets.pop_back();
+    }
+
+    return packets;
+}
+
+// renders progressively for `millis`, the image holds as many samples per pixel as fit in that time, starting at first_sample
+[[nodiscard]] std::shared_ptr<Karbon::Color[]> render_for(const Karbon::Scene &scene, const int threads, const int millis, int &samples, const int first_sample = 0)
+{
+    Karbon::ProgressiveRenderer renderer;
+    renderer.set_publish_interval(0);
+    renderer.set_first_sample(first_sample);
+    renderer.start(scene.m_camera, scene.m_world, 0, threads);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+
+    renderer.stop();
+
+    return renderer.take_snapshot(samples);
+}
+
+// root mean square difference of two gamma corrected 0-255 images
+[[nodiscard]] double image_rmse(const Karbon::Color *a, const Karbon::Color *b, const size_t pixel_count)
+{
+    double sum = 0;
+
+    for (size_t i = 0; i < pixel_count; i++)
+    {
+        const double dr = a[i].r - b[i].r;
+        const double dg = a[i].g - b[i].g;
+        const double db = a[i].b - b[i].b;
+
+        sum += dr * dr + dg * dg + db * db;
+    }
+
+    return std::sqrt(sum / (3.0 * (double)pixel_count));
+}
+
+/**
+ * @brief Renders the scene for the same time with uniform light selection and with the light tree
+ *
+ * Both are compared against a render that gets 16 times as long and sends a shadow ray to every light
+ * (LightSampling::All), which is exact for point lights, so a bias in either selection strategy shows up as error
+ * instead of being shared with the reference. The reference starts at a sample index neither of them reaches, so its
+ * noise is independent of theirs.
+ */
+[[nodiscard]] std::vector<LightSamplingResult> compare_light_sampling(const std::string &name, const Karbon::Scene &scene, const int threads, const int millis)
+{
+    const size_t pixel_count = (size_t)scene.m_camera.get_width() * (size_t)scene.m_camera.get_height();
+
+    Karbon::Scene strategy_scene = scene;
+    strategy_scene.m_world.set_light_sampling(Karbon::LightSampling::All);
+
+    // far beyond the samples an equal time render reaches
+    constexpr int kReferenceFirstSample = 1 << 20;
+
+    int reference_samples = 0;
+    const auto reference = render_for(strategy_scene, threads, millis * 16, reference_samples, kReferenceFirstSample);
+
+    std::vector<LightSamplingResult> results;
+
+    if (!reference)
+        return results;
+
+    for (const auto sampling : {Karbon::LightSampling::Uniform, Karbon::LightSampling::Tree})
+    {
+        strategy_scene.m_world.set_light_sampling(sampling);
+
+        int samples = 0;
+        const auto image = render_for(strategy_scene, threads, millis, samples);
+
+        if (image)
+            results.push_back({name, Karbon::light_sampling_name(sampling), threads, samples, image_rmse(image.get(), reference.get(), pixel_count)});
+    }
+
+    return results;
+}
+
+// geometry memory of the instances in `world` and the fastest of `repeat` top-level rebuilds (World::update_transforms)
+[[nodiscard]] InstancingResult measure_instancing(const std::string &name, Karbon::World &world, const int repeat)
+{
+    InstancingResult result{name, 0, world.get_geometry().size(), world.get_geometry().memory_usage(), 0, std::numeric_limits<double>::infinity()};
+
+    for (const auto &shape : world.get_shapes())
+    {
+        const auto instance = dynamic_cast<const Karbon::Instance *>(shape.get());
+
+        if (instance == nullptr)
+            continue;
+
+        result.instances++;
+
+        if (const auto mesh = dynamic_cast<const Karbon::TriangleMesh *>(instance->get_prototype().get()))
+            result.copied_bytes += mesh->get_geometry()->memory_usage();
+    }
+
+    for (int run = 0; run < repeat; run++)
+    {
+        Karbon::Timer timer;
+        world.update_transforms();
+        result.rebuild_seconds = std::min(result.rebuild_seconds, (double)timer.elapsed());
+    }
+
+    return result;
+}
+
+void write_json(const std::string &path, const BenchmarkOptions &options, const std::vector<BenchmarkResult> &results, const std::vector<LightSamplingResult> &light_results,
+                const std::vector<InstancingResult> &instancing_results)
+{
+    nlohmann::json json;
+
+    json["version"] = "0.6.0";
+#ifdef NDEBUG
+    json["build"] = "release";
+#else
+    json["build"] = "debug";
+#endif
+    json["hardware_threads"] = kCORE_COUNT;
+    json["width"] = options.width;
+    json["height"] = options.height;
+    json["samples"] = options.samples;
+    json["depth"] = options.depth;
+    json["storage"] = options.storage == Karbon::ShapeStorage::Packed ? "packed" : "bvh";
+
+    nlohmann::json results_json = nlohmann::json::array();
+
+    for (const auto &result : results)
+    {
+        nlohmann::json result_json;
+
+        result_json["scene"] = result.scene;
+        result_json["shapes"] = result.shapes;
+        result_json["kind"] = result.kind;
+        result_json["threads"] = result.threads;
+        result_json["rays"] = result.rays;
+        result_json["seconds"] = result.seconds;
+        result_json["mrays_per_second"] = result.mrays_per_second();
+
+        results_json.emplace_back(result_json);
+    }
+
+    json["results"] = results_json;
+
+    nlohmann::json light_results_json = nlohmann::json::array();
+
+    for (const auto &result : light_results)
+        light_results_json.push_back({{"scene", result.scene}, {"sampling", result.sampling}, {"threads", result.threads}, {"milliseconds", options.light_time}, {"samples", result.samples}, {"rmse", result.rmse}});
+
+    json["light_sampling"] = light_results_json;
+
+    nlohmann::json instancing_json = nlohmann::json::array();
+
+    for (const auto &result : instancing_results)
+        instancing_json.push_back({{"scene", result.scene}, {"instances", result.instances}, {"geometries", result.geometries}, {"geometry_bytes", result.geometry_bytes}, {"copied_bytes", result.copied_bytes}, {"rebuild_seconds", result.rebuild_seconds}});
+
+    json["instancing"] = instancing_json;
+
+    std::ofstream file(path);
+    file << json.dump(4) << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options;
+
+    if (!parse_arguments(argc, argv, options))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    auto scenes = make_benchmark_scenes(options.scene_directory, options.count, options.width, options.height, options.samples, options.depth, options.light_count);
+
+    std::vector<BenchmarkResult> results;
+    std::vector<LightSamplingResult> light_results;
+    std::vector<InstancingResult> instancing_results;
+
+    std::cout << std::left << std::setw(16) << "scene" << std::setw(8) << "shapes" << std::setw(11) << "kind" << std::setw(9) << "threads"
+              << std::setw(12) << "rays" << std::setw(12) << "ms" << "Mrays/s" << std::endl;
+
+    auto report = [&](const BenchmarkResult &result)
+    {
+        std::cout << std::left << std::setw(16) << result.scene << std::setw(8) << result.shapes << std::setw(11) << result.kind << std::setw(9) << result.threads
+                  << std::setw(12) << result.rays << std::setw(12) << std::fixed << std::setprecision(2) << result.seconds * 1000.0 << std::setprecision(3) << result.mrays_per_second()
+                  << std::defaultfloat << std::endl;
+
+        results.emplace_back(result);
+    };
+
+    for (auto &[name, scene] : scenes)
+    {
+        if (!options.scene_filter.empty() && std::none_of(options.scene_filter.begin(), options.scene_filter.end(), [&](const std::string &prefix)
+                                                          { return name.rfind(prefix, 0) == 0; }))
+            continue;
+
+        scene.m_world.set_shape_storage(options.storage);
+
+        const size_t shape_count = scene.m_world.get_shapes().size();
+
+        if (!scene.m_world.get_geometry().empty())
+            instancing_results.emplace_back(measure_instancing(name, scene.m_world, options.repeat));
+
+        const auto primary_rays = make_primary_rays(scene.m_camera);
+        const auto primary_packets = make_primary_packets(scene.m_camera);
+        const auto secondary_rays = make_secondary_rays(scene.m_world, primary_rays);
+        const auto shadow_rays = make_shadow_rays(scene.m_world, primary_rays);
+        const auto shadow_packets = make_shadow_packets(scene.m_world, primary_packets);
+
+        size_t shadow_packet_rays = 0;
+
+        for (const auto &packet : shadow_packets)
+            shadow_packet_rays += packet.count();
+
+        for (const int threads : options.thread_counts)
+        {
+            report({name, shape_count, "primary", threads, primary_rays.size(), trace_rays(scene.m_world, primary_rays, threads, options.repeat)});
+            report({name, shape_count, "packet", threads, primary_rays.size(), trace_packets(scene.m_world, primary_packets, threads, options.repeat)});
+            report({name, shape_count, "secondary", threads, secondary_rays.size(), trace_rays(scene.m_world, secondary_rays, threads, options.repeat)});
+            report({name, shape_count, "shadow-ch", threads, shadow_rays.size(), trace_shadow_rays(scene.m_world, shadow_rays, false, threads, options.repeat)});
+            report({name, shape_count, "shadow", threads, shadow_rays.size(), trace_shadow_rays(scene.m_world, shadow_rays, true, threads, options.repeat)});
+            report({name, shape_count, "shadow-pkt", threads, shadow_packet_rays, trace_shadow_packets(scene.m_world, shadow_packets, threads, options.repeat)});
+
+            // full renders, the ray count comes from the global counter
+            auto measure_render = [&](const char *kind, const auto &render)
+            {
+                BenchmarkResult result{name, shape_count, kind, threads, 0, std::numeric_limits<double>::infinity()};
+
+                for (int run = 0; run < options.repeat; run++)
+                {
+                    const uint64_t rays_before = Karbon::RayCounter::total();
+
+                    Karbon::Timer timer;
+                    auto image = render();
+                    const double seconds = timer.elapsed();
+
+                    if (seconds < result.seconds)
+                    {
+                        result.seconds = seconds;
+                        result.rays = Karbon::RayCounter::total() - rays_before;
+                    }
+                }
+
+                report(result);
+            };
+
+            measure_render("path", [&]()
+                           { return scene.m_camera.render_tiled(scene.m_world, threads); });
+            measure_render("wavefront", [&]()
+                           { return scene.m_camera.render_wavefront(scene.m_world, threads); });
+        }
+
+        // at equal time, with the most threads measured
+        if (scene.m_world.get_lights().size() > 1)
+        {
+            const int threads = *std::max_element(options.thread_counts.begin(), options.thread_counts.end());
+
+            for (auto &result : compare_light_sampling(name, scene, threads, options.light_time))
+                light_results.emplace_back(result);
+        }
+    }
+
+    if (!light_results.empty())
+    {
+        std::cout << "\nLight sampling at equal time (" << options.light_time << " ms each), error against a 16x longer render that samples all lights\n";
+        std::cout << std::left << std::setw(16) << "scene" << std::setw(10) << "sampling" << std::setw(9) << "threads" << std::setw(8) << "spp" << "rmse" << std::endl;
+
+        for (const auto &result : light_results)
+            std::cout << std::left << std::setw(16) << result.scene << std::setw(10) << result.sampling << std::setw(9) << result.threads << std::setw(8) << result.samples
+                      << std::fixed << std::setprecision(3) << result.rmse << std::defaultfloat << std::endl;
+    }
+
+    if (!instancing_results.empty())
+    {
+        std::cout << "\nInstancing, geometry memory shared by the instances and the top-level rebuild after moving them\n";
+        std::cout << std::left << std::setw(16) << "scene" << std::setw(11) << "instances" << std::setw(12) << "geometries" << std::setw(10) << "MB" << std::setw(14) << "MB as copies" << "rebuild ms" << std::endl;
+
+        for (const auto &result : instancing_results)
+            std::cout << std::left << std::setw(16) << result.scene << std::setw(11) << result.instances << std::setw(12) << result.geometries << std::fixed << std::setprecision(2)
+                      << std::setw(10) << result.geometry_bytes / 1e6 << std::setw(14) << result.copied_bytes / 1e6 << std::setprecision(3) << result.rebuild_seconds * 1000.0
+                      << std::defaultfloat << std::endl;
+    }
+
+    if (!options.json_path.empty())
+    {
+        write_json(options.json_path, options, results, light_results, instancing_results);
+        std::cout << "Results written to " << options.json_path << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <Karbon.hpp>
+
+// Catalog of the canonical benchmark scenes, everything procedural is seeded so every build renders the same scene
+
+struct BenchmarkScene
+{
+    std::string name;
+    Karbon::Scene scene;
+};
+
+inline Karbon::Camera make_benchmark_camera(const int width, const int height)
+{
+    Karbon::Camera camera(width, height, (float)std::numbers::pi / 3);
+    camera.transform(Karbon::Point(0, 4, -14), Karbon::Point(0, 1, 0), Karbon::Vector(0, 1, 0));
+
+    return camera;
+}
+
+inline std::shared_ptr<Karbon::Shape> make_floor()
+{
+    auto floor = std::make_shared<Karbon::XZPlane>();
+    floor->set_material(std::make_shared<Karbon::Lambertian>(Karbon::Color(0.8f, 0.8f, 0.8f)));
+
+    return floor;
+}
+
+// places `count` unit shapes from make_shape (scaled down) on a jittered grid over the floor, make_material may be
+// empty to keep the shapes' own material
+inline Karbon::World make_grid_world(Karbon::World world, const int count, const uint32_t seed, const std::function<std::shared_ptr<Karbon::Shape>()> &make_shape,
+                                     const std::function<std::shared_ptr<Karbon::Material>(std::mt19937 &)> &make_material)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const int side = std::max(1, (int)std::ceil(std::sqrt((float)count)));
+    const float spacing = 20.0f / side;
+    const float radius = spacing * 0.35f;
+
+    std::vector<std::shared_ptr<Karbon::Shape>> shapes = {make_floor()};
+
+    for (int i = 0; i < count; i++)
+    {
+        const int gx = i % side;
+        const int gz = i / side;
+
+        float translation[3] = {-10.0f + (gx + 0.5f) * spacing + (unit(rng) - 0.5f) * spacing * 0.3f,
+                                radius * (1.0f + unit(rng) * 2.0f),
+                                -4.0f + (gz + 0.5f) * spacing + (unit(rng) - 0.5f) * spacing * 0.3f};
+        float rotation[3] = {unit(rng) * 3.0f, unit(rng) * 3.0f, unit(rng) * 3.0f};
+        float scale[3] = {radius, radius, radius};
+
+        auto shape = make_shape();
+        shape->transform(translation, rotation, scale);
+
+        if (make_material)
+            shape->set_material(make_material(rng));
+
+        shapes.emplace_back(shape);
+    }
+
+    world.add_shapes(shapes);
+
+    return world;
+}
+
+// places `count` unit shapes of type T (scaled down) on a jittered grid over the floor
+template <typename T>
+inline Karbon::World make_grid_world(const int count, const uint32_t seed, const std::function<std::shared_ptr<Karbon::Material>(std::mt19937 &)> &make_material)
+{
+    return make_grid_world(Karbon::World(), count, seed, []()
+                           { return std::make_shared<T>(); }, make_material);
+}
+
+// unit icosphere, every subdivision quadruples the 20 triangles of the icosahedron
+inline std::shared_ptr<Karbon::MeshGeometry> make_icosphere(const int subdivisions)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+
+    std::vector<Karbon::Point> positions = {{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+    std::vector<uint32_t> indices = {0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+                                     3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+
+    for (auto &p : positions)
+        p = Karbon::Point((p - Karbon::Point()).normalize());
+
+    for (int level = 0; level < subdivisions; level++)
+    {
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+        std::vector<uint32_t> subdivided;
+
+        auto midpoint = [&](const uint32_t a, const uint32_t b)
+        {
+            const auto [it, inserted] = midpoints.try_emplace({std::min(a, b), std::max(a, b)}, (uint32_t)positions.size());
+
+            if (inserted)
+            {
+                const Karbon::Point &pa = positions[a];
+                const Karbon::Point &pb = positions[b];
+
+                positions.emplace_back(Karbon::Vector(pa.x + pb.x, pa.y + pb.y, pa.z + pb.z).normalize());
+            }
+
+            return it->second;
+        };
+
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const uint32_t a = indices[i];
+            const uint32_t b = indices[i + 1];
+            const uint32_t c = indices[i + 2];
+
+            const uint32_t ab = midpoint(a, b);
+            const uint32_t bc = midpoint(b, c);
+            const uint32_t ca = midpoint(c, a);
+
+            subdivided.insert(subdivided.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+        }
+
+        indices = std::move(subdivided);
+    }
+
+    return std::make_shared<Karbon::MeshGeometry>(std::move(positions), std::move(indices));
+}
+
+// `count` instances of one icosphere mesh, they all share its triangles, BVH and material
+inline Karbon::World make_instance_world(const int count, const uint32_t seed)
+{
+    Karbon::World world;
+
+    auto prototype = std::make_shared<Karbon::TriangleMesh>(make_icosphere(4));
+    prototype->set_material(std::make_shared<Karbon::Lambertian>(Karbon::Color(0.7f, 0.5f, 0.3f)));
+
+    world.get_geometry().add("icosphere", prototype);
+
+    return make_grid_world(world, count, seed, [&prototype]()
+                           { return std::make_shared<Karbon::Instance>("icosphere", prototype); }, nullptr);
+}
+
+inline std::shared_ptr<Karbon::Material> make_mixed_material(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    Karbon::Color color(0.2f + unit(rng) * 0.8f, 0.2f + unit(rng) * 0.8f, 0.2f + unit(rng) * 0.8f);
+
+    if (unit(rng) < 0.3f)
+        return std::make_shared<Karbon::Metal>(color, unit(rng) * 0.3f);
+
+    return std::make_shared<Karbon::Lambertian>(color);
+}
+
+inline std::shared_ptr<Karbon::Material> make_glass_material(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    return std::make_shared<Karbon::Dielectric>(Karbon::Color(0.9f + unit(rng) * 0.1f, 0.9f + unit(rng) * 0.1f, 0.9f + unit(rng) * 0.1f), 1.3f + unit(rng) * 0.4f);
+}
+
+// scatters `count` point lights of random color and strength over the grid of make_grid_world, below the camera
+inline std::vector<std::shared_ptr<Karbon::Light>> make_grid_lights(const int count, const uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<std::shared_ptr<Karbon::Light>> lights;
+
+    for (int i = 0; i < count; i++)
+    {
+        auto light = std::make_shared<Karbon::PointLight>();
+
+        light->set_position(Karbon::Point(-10.0f + unit(rng) * 20.0f, 0.3f + unit(rng) * 2.7f, -4.0f + unit(rng) * 20.0f));
+        light->set_intensity(Karbon::Color(64.0f + unit(rng) * 191.0f, 64.0f + unit(rng) * 191.0f, 64.0f + unit(rng) * 191.0f));
+
+        // a few bright lights among many dim ones, uniform selection wastes most of its samples on the dim ones
+        light->set_strength(std::pow(10.0f, unit(rng) * 2.0f - 1.0f));
+
+        lights.emplace_back(light);
+    }
+
+    return lights;
+}
+
+/**
+ * @brief Builds the benchmark catalog
+ *
+ * @param scene_directory Directory holding the bundled scene files (Default_Scene.json)
+ * @param count Number of shapes in the procedural scenes
+ * @param width Image width
+ * @param height Image height
+ * @param samples Antialiasing samples per pixel for the full path renders
+ * @param depth Maximum bounce depth
+ * @param light_count Number of point lights in the many-lights scene, 0 leaves it out
+ * @return std::vector<BenchmarkScene>
+ */
+inline std::vector<BenchmarkScene> make_benchmark_scenes(const std::string &scene_directory, const int count, const int width, const int height, const int samples, const int depth, const int light_count)
+{
+    std::vector<BenchmarkScene> scenes;
+
+    auto add_scene = [&](const std::string &name, Karbon::Scene scene)
+    {
+        scene.m_camera.set_width(width);
+        scene.m_camera.set_height(height);
+        scene.m_world.set_antialiasing_samples(samples);
+        scene.m_world.set_max_recurtion_level(depth);
+
+        scenes.push_back({name, scene});
+    };
+
+    const std::string default_scene_path = scene_directory + "/Default_Scene.json";
+
+    if (std::filesystem::exists(default_scene_path))
+    {
+        Karbon::Scene scene(make_benchmark_camera(width, height), Karbon::World());
+        scene.load_scene(default_scene_path);
+        add_scene("default", scene);
+    }
+    else
+        std::cerr << "Skipping the default scene, " << default_scene_path << " not found\n";
+
+    add_scene("spheres_" + std::to_string(count), Karbon::Scene(make_benchmark_camera(width, height), make_grid_world<Karbon::Sphere>(count, 1, make_mixed_material)));
+    add_scene("cubes_" + std::to_string(count), Karbon::Scene(make_benchmark_camera(width, height), make_grid_world<Karbon::Cube>(count, 2, make_mixed_material)));
+    add_scene("glass_64", Karbon::Scene(make_benchmark_camera(width, height), make_grid_world<Karbon::Sphere>(64, 3, make_glass_material)));
+    add_scene("instances_" + std::to_string(count), Karbon::Scene(make_benchmark_camera(width, height), make_instance_world(count, 6)));
+
+    if (light_count > 0)
+    {
+        Karbon::World world = make_grid_world<Karbon::Sphere>(count, 4, make_mixed_material);
+        world.add_lights(make_grid_lights(light_count, 5));
+
+        add_scene("lights_" + std::to_string(light_count), Karbon::Scene(make_benchmark_camera(width, height), world));
+    }
+
+    return scenes;
+}
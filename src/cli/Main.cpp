@@ -0,0 +1,449 @@
+#include <Karbon.hpp>
+
+// Headless renderer: loads a scene file, renders it and writes the image to disk
+
+struct Options
+{
+    std::string scene_path;
+    std::string output_path = "render.png";
+    int threads = kCORE_COUNT;
+    int samples = -1; // -1 keeps the value stored in the scene
+    int depth = -1;   // -1 keeps the value stored in the scene
+    int width = -1;   // -1 keeps the value stored in the scene
+    int height = -1;  // -1 keeps the value stored in the scene
+    std::string mode = "tiles";
+    int tile_size = -1; // -1 uses the default of the mode
+    std::string storage; // empty keeps the value stored in the scene
+    std::string sampler; // empty keeps the value stored in the scene
+    std::string lights;  // empty keeps the value stored in the scene
+    bool packets = true;
+    int timeout = 0; // milliseconds, 0 waits for the render however long it takes
+    float adaptive_threshold = 0; // 0 keeps the adaptive sampling settings stored in the scene
+    int min_samples = -1;         // -1 keeps the value stored in the scene
+};
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " <scene.json> [options]\n"
+              << "\n"
+              << "Options:\n"
+              << "  -o, --output <file>     Output image (.png, .jpg, .bmp, .tga), default render.png\n"
+              << "  -t, --threads <n>       Number of render threads, default " << kCORE_COUNT << "\n"
+              << "  -s, --samples <n>       Antialiasing samples per pixel, default from the scene\n"
+              << "  -d, --depth <n>         Maximum bounce depth, default from the scene\n"
+              << "  -W, --width <n>         Image width, default from the scene\n"
+              << "  -H, --height <n>        Image height, default from the scene\n"
+              << "  -m, --mode <rows|tiles|wavefront|progressive> Work scheduling, default tiles\n"
+              << "      --tile-size <n>     Tile edge length in pixels, default 16 (64 in wavefront mode)\n"
+              << "      --storage <bvh|packed> Shape storage, default from the scene\n"
+              << "      --sampler <random|stratified|sobol|bluenoise> Sample distribution, default from the scene\n"
+              << "      --lights <all|uniform|tree> How direct lighting picks lights, default from the scene\n"
+              << "      --adaptive <error>  Adaptive sampling (rows/tiles mode): a pixel stops once the standard error of its\n"
+              << "                          displayed value is below <error> (0-1, e.g. 0.005), --samples is the maximum\n"
+              << "      --min-samples <n>   Samples every pixel takes before adaptive sampling may stop it, default from the scene\n"
+              << "      --timeout <ms>      Cancel the render after this long (tiles mode), exits with 1\n"
+              << "      --no-packets        Trace camera rays one by one instead of in 4x4 packets (tiles/wavefront mode)\n"
+              << "  -h, --help              Show this message\n";
+}
+
+[[nodiscard]] bool parse_arguments(const int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        auto next_value = [&](const char *name) -> const char *
+        {
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << name << "\n";
+                return nullptr;
+            }
+
+            return argv[++i];
+        };
+
+        auto next_int = [&](const char *name, int &out)
+        {
+            const char *value = next_value(name);
+
+            if (!value)
+                return false;
+
+            try
+            {
+                out = std::stoi(value);
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Invalid value for " << name << ": " << value << "\n";
+                return false;
+            }
+
+            return true;
+        };
+
+        auto next_float = [&](const char *name, float &out)
+        {
+            const char *value = next_value(name);
+
+            if (!value)
+                return false;
+
+            try
+            {
+                out = std::stof(value);
+            }
+            catch (const std::exception &)
+            {
+                std::cerr << "Invalid value for " << name << ": " << value << "\n";
+                return false;
+            }
+
+            return true;
+        };
+
+        if (arg == "-h" || arg == "--help")
+            return false;
+        else if (arg == "-o" || arg == "--output")
+        {
+            const char *value = next_value("--output");
+            if (!value)
+                return false;
+            options.output_path = value;
+        }
+        else if (arg == "-m" || arg == "--mode")
+        {
+            const char *value = next_value("--mode");
+            if (!value)
+                return false;
+            options.mode = value;
+        }
+        else if (arg == "-t" || arg == "--threads")
+        {
+            if (!next_int("--threads", options.threads))
+                return false;
+        }
+        else if (arg == "-s" || arg == "--samples")
+        {
+            if (!next_int("--samples", options.samples))
+                return false;
+        }
+        else if (arg == "-d" || arg == "--depth")
+        {
+            if (!next_int("--depth", options.depth))
+                return false;
+        }
+        else if (arg == "-W" || arg == "--width")
+        {
+            if (!next_int("--width", options.width))
+                return false;
+        }
+        else if (arg == "-H" || arg == "--height")
+        {
+            if (!next_int("--height", options.height))
+                return false;
+        }
+        else if (arg == "--tile-size")
+        {
+            if (!next_int("--tile-size", options.tile_size))
+                return false;
+        }
+        else if (arg == "--timeout")
+        {
+            if (!next_int("--timeout", options.timeout))
+                return false;
+        }
+        else if (arg == "--adaptive")
+        {
+            if (!next_float("--adaptive", options.adaptive_threshold))
+                return false;
+        }
+        else if (arg == "--min-samples")
+        {
+            if (!next_int("--min-samples", options.min_samples))
+                return false;
+        }
+        else if (arg == "--no-packets")
+            options.packets = false;
+        else if (arg == "--storage")
+        {
+            const char *value = next_value("--storage");
+            if (!value)
+                return false;
+            options.storage = value;
+        }
+        else if (arg == "--sampler")
+        {
+            const char *value = next_value("--sampler");
+            if (!value)
+                return false;
+            options.sampler = value;
+        }
+        else if (arg == "--lights")
+        {
+            const char *value = next_value("--lights");
+            if (!value)
+                return false;
+            options.lights = value;
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        }
+        else if (options.scene_path.empty())
+            options.scene_path = arg;
+        else
+        {
+            std::cerr << "Unexpected argument: " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (options.scene_path.empty())
+    {
+        std::cerr << "No scene file given\n";
+        return false;
+    }
+
+    if (options.mode != "rows" && options.mode != "tiles" && options.mode != "wavefront" && options.mode != "progressive")
+    {
+        std::cerr << "Unknown mode: " << options.mode << "\n";
+        return false;
+    }
+
+    if (!options.storage.empty() && options.storage != "bvh" && options.storage != "packed")
+    {
+        std::cerr << "Unknown storage: " << options.storage << "\n";
+        return false;
+    }
+
+    Karbon::SamplerKind sampler;
+    if (!options.sampler.empty() && !Karbon::sampler_kind_from_name(options.sampler, sampler))
+    {
+        std::cerr << "Unknown sampler: " << options.sampler << "\n";
+        return false;
+    }
+
+    Karbon::LightSampling light_sampling;
+    if (!options.lights.empty() && !Karbon::light_sampling_from_name(options.lights, light_sampling))
+    {
+        std::cerr << "Unknown light sampling: " << options.lights << "\n";
+        return false;
+    }
+
+    if (options.tile_size == -1)
+        options.tile_size = options.mode == "wavefront" ? 64 : 16;
+
+    if (options.threads < 1 || options.tile_size < 1)
+    {
+        std::cerr << "Thread count and tile size have to be positive\n";
+        return false;
+    }
+
+    // every mode but rows runs on the shared pool, which has one worker per core, so the count reported is the one used
+    if (options.mode != "rows" && options.threads > Karbon::ThreadPool::Get().size())
+    {
+        std::cerr << "Using " << Karbon::ThreadPool::Get().size() << " threads instead of " << options.threads << ", one per core\n";
+        options.threads = Karbon::ThreadPool::Get().size();
+    }
+
+    if (options.adaptive_threshold < 0)
+    {
+        std::cerr << "The adaptive error threshold can't be negative\n";
+        return false;
+    }
+
+    if (options.timeout < 0)
+    {
+        std::cerr << "The timeout can't be negative\n";
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    if (!parse_arguments(argc, argv, options))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!std::filesystem::exists(options.scene_path))
+    {
+        std::cerr << "Scene file not found: " << options.scene_path << "\n";
+        return 1;
+    }
+
+#if PROFILING
+    Instrumentor::Get().beginSession("CLI");
+#endif
+
+    Karbon::Scene scene(Karbon::Camera(800, 600, (float)std::numbers::pi / 3), Karbon::World());
+
+    Karbon::Timer load_timer;
+
+    try
+    {
+        scene.load_scene(options.scene_path);
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+        std::cerr << "Failed to load scene " << options.scene_path << ": " << e.what() << "\n";
+        return 1;
+    }
+
+    const float load_time = load_timer.elapsed_millis();
+
+    if (options.samples > 0)
+        scene.m_world.set_antialiasing_samples(options.samples);
+    if (options.depth > 0)
+        scene.m_world.set_max_recurtion_level(options.depth);
+    if (options.width > 0)
+        scene.m_camera.set_width(options.width);
+    if (options.height > 0)
+        scene.m_camera.set_height(options.height);
+    scene.m_camera.set_packet_tracing(options.packets);
+    Karbon::SamplerKind sampler;
+    if (Karbon::sampler_kind_from_name(options.sampler, sampler))
+        scene.m_world.set_sampler(sampler);
+    Karbon::LightSampling light_sampling;
+    if (Karbon::light_sampling_from_name(options.lights, light_sampling))
+        scene.m_world.set_light_sampling(light_sampling);
+
+    Karbon::AdaptiveSampling adaptive = scene.m_world.get_adaptive_sampling();
+    if (options.adaptive_threshold > 0)
+    {
+        adaptive.m_enabled = true;
+        adaptive.m_threshold = options.adaptive_threshold;
+    }
+    if (options.min_samples > 0)
+        adaptive.m_min_samples = options.min_samples;
+    scene.m_world.set_adaptive_sampling(adaptive);
+    if (!options.storage.empty())
+        scene.m_world.set_shape_storage(options.storage == "packed" ? Karbon::ShapeStorage::Packed : Karbon::ShapeStorage::BVH);
+
+    const int width = scene.m_camera.get_width();
+    const int height = scene.m_camera.get_height();
+    const int samples = scene.m_world.get_antialiasing_samples();
+
+    std::cout << "Scene:      " << options.scene_path << " (" << scene.m_world.get_shapes().size() << " shapes, " << scene.m_world.get_lights().size() << " lights (" << Karbon::light_sampling_name(scene.m_world.get_light_sampling()) << " sampling), loaded in " << load_time << " ms)\n";
+    std::cout << "Image:      " << width << "x" << height << ", " << samples << " spp (" << Karbon::sampler_kind_name(scene.m_world.get_sampler()) << "), depth " << scene.m_world.get_max_recurtion_level() << "\n";
+    if (adaptive.m_enabled)
+        std::cout << "Adaptive:   " << adaptive.m_min_samples << " - " << samples << " spp, error threshold " << adaptive.m_threshold << "\n";
+    std::cout << "Storage:    " << (scene.m_world.get_shape_storage() == Karbon::ShapeStorage::Packed ? "packed" : "bvh") << "\n";
+    std::cout << "Scheduling: " << options.mode << ", " << options.threads << " threads";
+    if (options.mode == "tiles" || options.mode == "wavefront")
+        std::cout << ", " << options.tile_size << "px tiles" << (options.packets ? ", 4x4 packets" : "");
+    std::cout << std::endl;
+
+    Karbon::Timer render_timer;
+
+    std::shared_ptr<Karbon::Color[]> image;
+
+    // camera samples actually traced, with adaptive sampling fewer than pixels * samples
+    const double pixels = (double)width * height;
+    double camera_samples = pixels * samples;
+
+    if (options.mode == "tiles" && options.timeout > 0)
+    {
+        // a background job that is given up on once the timeout passes
+        Karbon::RenderQueue queue;
+        Karbon::RenderJobHandle job = queue.submit(scene.m_camera, scene.m_world, {0, options.threads, options.tile_size, Karbon::TileOrder::Morton});
+
+        if (!job.wait_for(std::chrono::milliseconds(options.timeout)))
+        {
+            job.cancel();
+
+            const Karbon::RenderProgress progress = job.get_progress();
+
+            std::cerr << "Render timed out after " << options.timeout << " ms with " << progress.m_tiles_done << "/" << progress.m_tile_count << " tiles done\n";
+            return 1;
+        }
+
+        image = job.get();
+        camera_samples = (double)job.get_progress().m_samples_done;
+    }
+    else if (options.mode == "tiles")
+        image = scene.m_camera.render_tiled(scene.m_world, options.threads, options.tile_size);
+    else if (options.mode == "wavefront")
+        image = scene.m_camera.render_wavefront(scene.m_world, options.threads, options.tile_size);
+    else if (options.mode == "progressive")
+    {
+        // one pass per sample, keep the last snapshot and report how soon the first one was ready
+        Karbon::ProgressiveRenderer progressive;
+        progressive.start(scene.m_camera, scene.m_world, samples, options.threads);
+
+        float first_image_time = -1;
+        int snapshot_samples = 0;
+
+        for (;;)
+        {
+            // read before taking the snapshot, a render that already ended has published its last one
+            const bool running = progressive.is_running();
+
+            if (auto snapshot = progressive.take_snapshot(snapshot_samples))
+            {
+                if (first_image_time < 0)
+                    first_image_time = render_timer.elapsed_millis();
+
+                image = snapshot;
+            }
+            else if (!running)
+                break;
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::cout << "First image: " << first_image_time << " ms (" << snapshot_samples << " spp at the end)\n";
+    }
+    else
+        image = scene.m_camera.render_multi_threaded(scene.m_world, options.threads);
+
+    const float render_seconds = render_timer.elapsed();
+
+    if (options.mode != "progressive" && !(options.mode == "tiles" && options.timeout > 0))
+    {
+        camera_samples = 0;
+
+        for (const auto &stats : scene.m_camera.get_tile_stats())
+            camera_samples += (double)stats.m_samples;
+    }
+
+    std::cout << "Render:     " << render_seconds * 1000.0f << " ms\n";
+    std::cout << "Throughput: " << pixels / render_seconds / 1e6 << " Mpixels/s, " << camera_samples / render_seconds / 1e6 << " Msamples/s, "
+              << camera_samples / render_seconds / options.threads / 1e6 << " Msamples/s per thread\n";
+    if (adaptive.m_enabled)
+        std::cout << "Samples:    " << camera_samples / pixels << " spp on average\n";
+
+    if (options.mode == "tiles" || options.mode == "wavefront")
+    {
+        auto worker_times = scene.m_camera.get_worker_times();
+
+        if (!worker_times.empty())
+        {
+            auto [min_time, max_time] = std::minmax_element(worker_times.begin(), worker_times.end());
+
+            std::cout << "Tiles:      " << scene.m_camera.get_tile_stats().size() << ", worker busy time " << *min_time << " - " << *max_time << " ms\n";
+        }
+    }
+
+#if PROFILING
+    Instrumentor::Get().endSession();
+#endif
+
+    if (Karbon::save_image(image, width, height, options.output_path) < 0)
+    {
+        std::cerr << "Failed to write " << options.output_path << "\n";
+        return 1;
+    }
+
+    std::cout << "Output:     " << options.output_path << std::endl;
+
+    return 0;
+}